@@ -8,6 +8,8 @@ public class BonedShooter : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "NetCore", "InputCore", "HeadMountedDisplay", "AnimGraphRuntime", "ReplicationGraph" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Json" });
 	}
 }
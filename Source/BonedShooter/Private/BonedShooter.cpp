@@ -4,4 +4,24 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, BonedShooter, "BonedShooter" );
- 
\ No newline at end of file
+
+DEFINE_STAT(STAT_BonedShooter_WeaponFire);
+DEFINE_STAT(STAT_BonedShooter_ServerFireBatch);
+DEFINE_STAT(STAT_BonedShooter_ProcessShot);
+DEFINE_STAT(STAT_BonedShooter_BulletHit);
+DEFINE_STAT(STAT_BonedShooter_BulletMovement);
+DEFINE_STAT(STAT_BonedShooter_ResolveDamage);
+DEFINE_STAT(STAT_BonedShooter_ReplicateAim);
+DEFINE_STAT(STAT_BonedShooter_SpawnWeapon);
+
+DEFINE_STAT(STAT_BonedShooter_ShotsFired);
+DEFINE_STAT(STAT_BonedShooter_ShotsProcessed);
+DEFINE_STAT(STAT_BonedShooter_ShotsRejected);
+DEFINE_STAT(STAT_BonedShooter_BulletsSpawned);
+DEFINE_STAT(STAT_BonedShooter_Hits);
+DEFINE_STAT(STAT_BonedShooter_AimRPCs);
+DEFINE_STAT(STAT_BonedShooter_AimUpdates);
+DEFINE_STAT(STAT_BonedShooter_AimTraces);
+DEFINE_STAT(STAT_BonedShooter_BulletSweeps);
+
+CSV_DEFINE_CATEGORY_MODULE(BONEDSHOOTER_API, BonedShooter, true);
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayCore/AnimNode_BoneScaling.h"
+
+#include "Animation/AnimClassInterface.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "GameplayCore/BonedShooterAnimInstance.h"
+
+void FAnimNode_BoneScaling::UpdateInternal(const FAnimationUpdateContext& Context)
+{
+	Super::UpdateInternal(Context);
+
+	// The proxy bumps the revision whenever the character's scales change, most frames copy nothing
+	const UClass* AnimClass = IAnimClassInterface::GetActualAnimClass(Context.AnimInstanceProxy->GetAnimClassInterface());
+	if (AnimClass == nullptr || !AnimClass->IsChildOf<UBonedShooterAnimInstance>())
+	{
+		return;
+	}
+
+	const FBonedShooterAnimInstanceProxy* Proxy = static_cast<FBonedShooterAnimInstanceProxy*>(Context.AnimInstanceProxy);
+	if (Proxy->GetBoneScalesRevision() != BoneScalesRevision)
+	{
+		BoneScales = Proxy->GetBoneScales();
+		BoneScalesRevision = Proxy->GetBoneScalesRevision();
+		bCachedBonesDirty = true;
+	}
+}
+
+void FAnimNode_BoneScaling::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	// LOD changed, the compact pose indices with it
+	bCachedBonesDirty = true;
+}
+
+bool FAnimNode_BoneScaling::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
+{
+	return BoneScales.Num() > 0;
+}
+
+void FAnimNode_BoneScaling::CacheCompactPoseBones(const FBoneContainer& RequiredBones)
+{
+	CachedBones.Reset();
+	for (const FReplicatedBoneScale& BoneScale : BoneScales)
+	{
+		const FCompactPoseBoneIndex CompactIndex = RequiredBones.MakeCompactPoseIndex(FMeshPoseBoneIndex(BoneScale.BoneIndex));
+		if (CompactIndex.IsValid())
+		{
+			CachedBones.Add({ CompactIndex, BoneScale.GetScale(), INDEX_NONE });
+		}
+	}
+	CachedBones.Sort([](const FCachedBoneScale& A, const FCachedBoneScale& B) { return A.BoneIndex.GetInt() < B.BoneIndex.GetInt(); });
+
+	// Parents come before their children in the compact pose, so a scaled ancestor is an earlier entry
+	for (int32 Entry = 1; Entry < CachedBones.Num(); ++Entry)
+	{
+		for (FCompactPoseBoneIndex Parent = RequiredBones.GetParentBoneIndex(CachedBones[Entry].BoneIndex);
+			Parent.IsValid() && CachedBones[Entry].ScaledAncestor == INDEX_NONE; Parent = RequiredBones.GetParentBoneIndex(Parent))
+		{
+			CachedBones[Entry].ScaledAncestor = CachedBones.IndexOfByPredicate([Parent](const FCachedBoneScale& Other) { return Other.BoneIndex == Parent; });
+		}
+	}
+	bCachedBonesDirty = false;
+}
+
+void FAnimNode_BoneScaling::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
+{
+	if (bCachedBonesDirty)
+	{
+		CacheCompactPoseBones(Output.Pose.GetPose().GetBoneContainer());
+	}
+
+	// Scaling in component space also scales the children, which are rebuilt from their local transforms. A scaled
+	// bone under a scaled ancestor is written in component space too, so it has to carry the ancestor's new transform
+	// itself, the way ApplyBoneScalesToPhysics composes the scales of the bodies.
+	const int32 FirstOutput = OutBoneTransforms.Num();
+	for (const FCachedBoneScale& CachedBone : CachedBones)
+	{
+		FTransform BoneTransform = Output.Pose.GetComponentSpaceTransform(CachedBone.BoneIndex);
+		if (CachedBone.ScaledAncestor != INDEX_NONE)
+		{
+			const FCachedBoneScale& Ancestor = CachedBones[CachedBone.ScaledAncestor];
+			const FTransform RelativeToAncestor = BoneTransform.GetRelativeTransform(Output.Pose.GetComponentSpaceTransform(Ancestor.BoneIndex));
+			BoneTransform = RelativeToAncestor * OutBoneTransforms[FirstOutput + CachedBone.ScaledAncestor].Transform;
+		}
+		BoneTransform.SetScale3D(BoneTransform.GetScale3D() * CachedBone.Scale);
+		OutBoneTransforms.Add(FBoneTransform(CachedBone.BoneIndex, BoneTransform));
+	}
+}
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayCore/AnimationBenchmarkSubsystem.h"
+
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameplayCore/BonedShooterCharacter.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderCore.h"
+
+// Distance between two characters of the crowd, enough for capsules not to push each other
+static constexpr float CrowdSpacing = 200.f;
+
+bool UAnimationBenchmarkSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && (World->WorldType == EWorldType::Game || World->WorldType == EWorldType::PIE);
+}
+
+void UAnimationBenchmarkSubsystem::Deinitialize()
+{
+	Characters.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UAnimationBenchmarkSubsystem::IsTickable() const
+{
+	return !IsTemplate() && IsRunning();
+}
+
+TStatId UAnimationBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAnimationBenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+void UAnimationBenchmarkSubsystem::StartBenchmark(TSubclassOf<ABonedShooterCharacter> CharacterClass, int32 NumCharacters, int32 NumFrames, int32 WarmupFrames)
+{
+	if (IsRunning() || CharacterClass == nullptr || NumCharacters <= 0 || NumFrames <= 0)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	const int32 RowLength = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCharacters)));
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	for (int32 Index = 0; Index < NumCharacters; ++Index)
+	{
+		const FVector Location((Index % RowLength) * CrowdSpacing, (Index / RowLength) * CrowdSpacing, 200.f);
+		ABonedShooterCharacter* Character = World->SpawnActor<ABonedShooterCharacter>(CharacterClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (Character)
+		{
+			// Without a viewport nothing is rendered, animate regardless
+			Character->GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+			// Movement only runs for controlled characters
+			Character->SpawnDefaultController();
+			Characters.Add(Character);
+		}
+	}
+
+	FramesToSkip = FMath::Max(WarmupFrames, 0);
+	FramesToRecord = NumFrames;
+	ElapsedTime = 0.f;
+	Result = FAnimationBenchmarkResult();
+	Result.NumCharacters = Characters.Num();
+
+	UE_LOG(LogTemp, Log, TEXT("Animation benchmark: %d x %s, %d frames"), Result.NumCharacters, *CharacterClass->GetName(), NumFrames);
+}
+
+void UAnimationBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	ElapsedTime += DeltaTime;
+
+	// Keep every input of the anim graph changing: walk in circles and sweep the aim
+	for (int32 Index = 0; Index < Characters.Num(); ++Index)
+	{
+		ABonedShooterCharacter* Character = Characters[Index];
+		if (IsValid(Character))
+		{
+			const float Phase = ElapsedTime + Index * 0.37f;
+			Character->AddMovementInput(FVector(FMath::Cos(Phase), FMath::Sin(Phase), 0.f));
+			Character->SetTargetAimRotation(FRotator(FMath::Sin(Phase * 1.3f) * 60.f, Phase * 20.f, 0.f));
+		}
+	}
+
+	if (FramesToSkip > 0)
+	{
+		--FramesToSkip;
+		return;
+	}
+
+	// Time of the previous game thread frame, the one the crowd was last animated in
+	const double GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Result.AverageGameThreadMs += GameThreadMs;
+	Result.PeakGameThreadMs = FMath::Max(Result.PeakGameThreadMs, GameThreadMs);
+	++Result.NumFrames;
+
+	if (--FramesToRecord <= 0)
+	{
+		FinishBenchmark();
+	}
+}
+
+void UAnimationBenchmarkSubsystem::FinishBenchmark()
+{
+	Result.AverageGameThreadMs /= FMath::Max(Result.NumFrames, 1);
+	UE_LOG(LogTemp, Log, TEXT("Animation benchmark: %d characters, %d frames, game thread avg %.3f ms, peak %.3f ms"),
+		Result.NumCharacters, Result.NumFrames, Result.AverageGameThreadMs, Result.PeakGameThreadMs);
+
+	for (ABonedShooterCharacter* Character : Characters)
+	{
+		if (IsValid(Character))
+		{
+			Character->Destroy();
+		}
+	}
+	Characters.Empty();
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GBenchmarkAnimationCommand(
+	TEXT("BonedShooter.BenchmarkAnimation"),
+	TEXT("Spawns a crowd of moving, aiming characters and logs the game thread time.\n")
+	TEXT("Usage: BonedShooter.BenchmarkAnimation [NumCharacters=64] [NumFrames=600] [CharacterClassPath=default pawn]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UAnimationBenchmarkSubsystem* Benchmark = World ? World->GetSubsystem<UAnimationBenchmarkSubsystem>() : nullptr;
+		if (Benchmark == nullptr)
+		{
+			return;
+		}
+
+		const int32 NumCharacters = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 64;
+		const int32 NumFrames = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 600;
+
+		UClass* CharacterClass = nullptr;
+		if (Args.Num() > 2)
+		{
+			CharacterClass = LoadClass<ABonedShooterCharacter>(nullptr, *Args[2]);
+		}
+		else if (const AGameModeBase* GameMode = World->GetAuthGameMode())
+		{
+			CharacterClass = GameMode->DefaultPawnClass;
+		}
+
+		Benchmark->StartBenchmark(CharacterClass, NumCharacters, NumFrames, 60);
+	}));
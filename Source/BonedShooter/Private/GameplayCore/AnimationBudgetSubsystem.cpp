@@ -0,0 +1,216 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayCore/AnimationBudgetSubsystem.h"
+
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameplayCore/BonedShooterCharacter.h"
+#include "HAL/IConsoleManager.h"
+
+bool UAnimationBudgetSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	// Nothing is drawn on a dedicated server, its animation serves hit detection and stays at full rate
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && (World->WorldType == EWorldType::Game || World->WorldType == EWorldType::PIE) && !IsRunningDedicatedServer();
+}
+
+void UAnimationBudgetSubsystem::Deinitialize()
+{
+	Characters.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UAnimationBudgetSubsystem::IsTickable() const
+{
+	return !IsTemplate() && Characters.Num() > 0;
+}
+
+TStatId UAnimationBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAnimationBudgetSubsystem, STATGROUP_Tickables);
+}
+
+void UAnimationBudgetSubsystem::RegisterCharacter(ABonedShooterCharacter* Character)
+{
+	if (Character && !Characters.ContainsByPredicate([Character](const FBudgetedCharacter& Entry) { return Entry.Character == Character; }))
+	{
+		FBudgetedCharacter& Entry = Characters.AddDefaulted_GetRef();
+		Entry.Character = Character;
+	}
+}
+
+void UAnimationBudgetSubsystem::UnregisterCharacter(ABonedShooterCharacter* Character)
+{
+	const int32 Index = Characters.IndexOfByPredicate([Character](const FBudgetedCharacter& Entry) { return Entry.Character == Character; });
+	if (Index != INDEX_NONE)
+	{
+		Characters.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+float UAnimationBudgetSubsystem::GetTickInterval(EAnimationBudgetTier Tier) const
+{
+	switch (Tier)
+	{
+	case EAnimationBudgetTier::Reduced:
+		return ReducedTickInterval;
+	case EAnimationBudgetTier::Low:
+		return LowTickInterval;
+	case EAnimationBudgetTier::Offscreen:
+		return OffscreenTickInterval;
+	default:
+		return 0.f;
+	}
+}
+
+float UAnimationBudgetSubsystem::GetEstimatedCostMs(EAnimationBudgetTier Tier, float DeltaTime) const
+{
+	// A character ticking every N frames costs about 1/N of a full rate one, Low skips the bone refresh on top
+	const float TickInterval = GetTickInterval(Tier);
+	const float UpdateFraction = TickInterval > DeltaTime ? DeltaTime / TickInterval : 1.f;
+	switch (Tier)
+	{
+	case EAnimationBudgetTier::Low:
+		return EstimatedFullRateCostMs * UpdateFraction * 0.5f;
+	case EAnimationBudgetTier::Offscreen:
+		return 0.f;
+	default:
+		return EstimatedFullRateCostMs * UpdateFraction;
+	}
+}
+
+void UAnimationBudgetSubsystem::Tick(float DeltaTime)
+{
+	const APlayerController* LocalPlayerController = GetWorld()->GetFirstPlayerController();
+	if (LocalPlayerController == nullptr)
+	{
+		return;
+	}
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	LocalPlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	// Tier earned by distance and visibility alone
+	for (int32 Index = Characters.Num() - 1; Index >= 0; --Index)
+	{
+		FBudgetedCharacter& Entry = Characters[Index];
+		const ABonedShooterCharacter* Character = Entry.Character.Get();
+		if (Character == nullptr)
+		{
+			Characters.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		const float Distance = FVector::Dist(ViewLocation, Character->GetActorLocation());
+		const bool bOnScreen = Character->GetMesh()->WasRecentlyRendered(OffscreenDelay);
+		if (!bOnScreen)
+		{
+			Entry.DesiredTier = EAnimationBudgetTier::Offscreen;
+		}
+		else if (Distance <= FullTierDistance)
+		{
+			Entry.DesiredTier = EAnimationBudgetTier::Full;
+		}
+		else if (Distance <= ReducedTierDistance)
+		{
+			Entry.DesiredTier = EAnimationBudgetTier::Reduced;
+		}
+		else
+		{
+			Entry.DesiredTier = EAnimationBudgetTier::Low;
+		}
+
+		// Anything on screen outranks anything off screen, then closer outranks farther
+		Entry.Significance = (bOnScreen ? 1.f : 0.f) + 1.f / (1.f + Distance);
+	}
+
+	Characters.Sort([](const FBudgetedCharacter& A, const FBudgetedCharacter& B) { return A.Significance > B.Significance; });
+
+	float EstimatedCostMs = 0.f;
+	for (const FBudgetedCharacter& Entry : Characters)
+	{
+		EstimatedCostMs += GetEstimatedCostMs(Entry.DesiredTier, DeltaTime);
+	}
+
+	// Over budget: demote from the least significant end, one tier at a time
+	Stats = FAnimationBudgetStats();
+	for (int32 Index = Characters.Num() - 1; Index >= 0 && EstimatedCostMs > AnimationBudgetMs; --Index)
+	{
+		FBudgetedCharacter& Entry = Characters[Index];
+		while (Entry.DesiredTier < EAnimationBudgetTier::Low && EstimatedCostMs > AnimationBudgetMs)
+		{
+			const EAnimationBudgetTier DemotedTier = static_cast<EAnimationBudgetTier>(static_cast<uint8>(Entry.DesiredTier) + 1);
+			EstimatedCostMs += GetEstimatedCostMs(DemotedTier, DeltaTime) - GetEstimatedCostMs(Entry.DesiredTier, DeltaTime);
+			Entry.DesiredTier = DemotedTier;
+			++Stats.NumDemoted;
+		}
+	}
+
+	for (FBudgetedCharacter& Entry : Characters)
+	{
+		// Component settings are only touched when the tier changes
+		if (Entry.DesiredTier != Entry.AppliedTier)
+		{
+			ApplyTier(Entry.Character.Get(), Entry.DesiredTier, GetTickInterval(Entry.DesiredTier));
+			Entry.AppliedTier = Entry.DesiredTier;
+		}
+
+		switch (Entry.AppliedTier)
+		{
+		case EAnimationBudgetTier::Full:
+			++Stats.NumFull;
+			break;
+		case EAnimationBudgetTier::Reduced:
+			++Stats.NumReduced;
+			break;
+		case EAnimationBudgetTier::Low:
+			++Stats.NumLow;
+			break;
+		default:
+			++Stats.NumOffscreen;
+			break;
+		}
+	}
+	Stats.EstimatedCostMs = EstimatedCostMs;
+}
+
+void UAnimationBudgetSubsystem::ApplyTier(ABonedShooterCharacter* Character, EAnimationBudgetTier Tier, float TickInterval)
+{
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	Mesh->SetComponentTickInterval(TickInterval);
+	Mesh->bEnableUpdateRateOptimizations = Tier != EAnimationBudgetTier::Full;
+
+	// Hits are decided on the server, far away proxies don't need their physics bodies to follow the bones
+	Mesh->KinematicBonesUpdateType = Tier == EAnimationBudgetTier::Full || Tier == EAnimationBudgetTier::Reduced
+		? EKinematicBonesUpdateToPhysics::SkipSimulatingBones
+		: EKinematicBonesUpdateToPhysics::SkipAllBones;
+	Mesh->VisibilityBasedAnimTickOption = Tier == EAnimationBudgetTier::Offscreen
+		? EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered
+		: EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+}
+
+void UAnimationBudgetSubsystem::DumpStats() const
+{
+	UE_LOG(LogTemp, Log, TEXT("Animation budget: full %d, reduced %d, low %d, offscreen %d, demoted %d, estimated %.3f / %.3f ms"),
+		Stats.NumFull, Stats.NumReduced, Stats.NumLow, Stats.NumOffscreen, Stats.NumDemoted, Stats.EstimatedCostMs, AnimationBudgetMs);
+}
+
+static FAutoConsoleCommandWithWorld GDumpAnimationBudgetCommand(
+	TEXT("BonedShooter.DumpAnimationBudget"),
+	TEXT("Logs how many remote characters are in each animation budget tier."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UAnimationBudgetSubsystem* Budget = World ? World->GetSubsystem<UAnimationBudgetSubsystem>() : nullptr)
+		{
+			Budget->DumpStats();
+		}
+	}));
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayCore/BonedShooterAnimInstance.h"
+
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameplayCore/BonedShooterCharacter.h"
+
+void FBonedShooterAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	Super::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	// Game thread: copy, don't compute
+	const ABonedShooterCharacter* Character = Cast<ABonedShooterCharacter>(InAnimInstance->TryGetPawnOwner());
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	Velocity = Character->GetVelocity();
+	ActorRotation = Character->GetActorRotation();
+	TargetAimRotation = Character->GetTargetAimRotation();
+	bIsAiming = Character->IsAiming();
+	bIsFalling = Character->GetCharacterMovement() && Character->GetCharacterMovement()->IsFalling();
+
+	if (BoneScalesRevision != Character->GetBoneScalesRevision())
+	{
+		BoneScales = Character->GetBoneScales();
+		BoneScalesRevision = Character->GetBoneScalesRevision();
+	}
+}
+
+void FBonedShooterAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	Super::Update(DeltaSeconds);
+
+	// Worker thread: the game thread doesn't touch the instance while its update is running
+	UBonedShooterAnimInstance* Instance = CastChecked<UBonedShooterAnimInstance>(GetAnimInstanceObject());
+
+	const FVector GroundVelocity(Velocity.X, Velocity.Y, 0.f);
+	Instance->Speed = GroundVelocity.Size();
+	Instance->bIsMoving = Instance->Speed > Instance->MovingSpeedThreshold;
+	Instance->bIsInAir = bIsFalling;
+	Instance->bIsAiming = bIsAiming;
+
+	// Same as UAnimInstance::CalculateDirection, which is not thread safe
+	Instance->Direction = 0.f;
+	if (Instance->bIsMoving)
+	{
+		const FRotationMatrix RotationMatrix(ActorRotation);
+		const FVector NormalizedVelocity = GroundVelocity / Instance->Speed;
+		const float ForwardCosAngle = FVector::DotProduct(RotationMatrix.GetScaledAxis(EAxis::X), NormalizedVelocity);
+		const float ForwardDeltaDegrees = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(ForwardCosAngle, -1.f, 1.f)));
+		const float RightCosAngle = FVector::DotProduct(RotationMatrix.GetScaledAxis(EAxis::Y), NormalizedVelocity);
+		Instance->Direction = RightCosAngle < 0.f ? -ForwardDeltaDegrees : ForwardDeltaDegrees;
+	}
+
+	const FRotator AimDelta = (TargetAimRotation - ActorRotation).GetNormalized();
+	Instance->AimPitch = AimDelta.Pitch;
+	Instance->AimYaw = AimDelta.Yaw;
+}
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayCore/BonedShooterBotController.h"
+
+#include "GameplayCore/BonedShooterCharacter.h"
+
+void FBonedShooterBotBrain::Init(int32 Seed)
+{
+	Stream.Initialize(Seed);
+	Time = 0.f;
+	NextDecisionTime = 0.f;
+	StrafeFrequency = Stream.FRandRange(0.3f, 1.5f);
+}
+
+void FBonedShooterBotBrain::Tick(AController* Controller, ABonedShooterCharacter* Character, float DeltaTime)
+{
+	if (Controller == nullptr || Character == nullptr)
+	{
+		return;
+	}
+
+	Time += DeltaTime;
+	if (Time >= NextDecisionTime)
+	{
+		NextDecisionTime = Time + Stream.FRandRange(1.f, 3.f);
+		TurnRate = Stream.FRandRange(-90.f, 90.f);
+		bWantsAim = Stream.FRand() < 0.7f;
+		bWantsFire = bWantsAim && Stream.FRand() < 0.6f;
+	}
+
+	// What InputTurn and InputLookUp do, without the player-only controller input scaling
+	FRotator ControlRotation = Controller->GetControlRotation();
+	ControlRotation.Yaw += TurnRate * DeltaTime;
+	ControlRotation.Pitch = FMath::Sin(Time * 0.7f) * 10.f;
+	Controller->SetControlRotation(ControlRotation);
+	Character->SetTargetAimRotation(ControlRotation);
+
+	Character->MoveForward(1.f);
+	Character->MoveRight(FMath::Sin(Time * StrafeFrequency * 2.f * PI));
+
+	if (bWantsAim != bAiming)
+	{
+		bAiming = bWantsAim;
+		if (bAiming)
+		{
+			Character->StartAiming();
+		}
+		else
+		{
+			Character->StopAiming();
+		}
+	}
+
+	// The trigger only works once the server has acknowledged the aim, like for a player
+	const bool bShouldFire = bWantsFire && Character->IsAiming();
+	if (bShouldFire != bFiring)
+	{
+		bFiring = bShouldFire;
+		if (bFiring)
+		{
+			Character->StartFire();
+		}
+		else
+		{
+			Character->EndFire();
+		}
+	}
+}
+
+void FBonedShooterBotBrain::Stop(ABonedShooterCharacter* Character)
+{
+	if (Character)
+	{
+		if (bFiring)
+		{
+			Character->EndFire();
+		}
+		if (bAiming)
+		{
+			Character->StopAiming();
+		}
+	}
+	bFiring = false;
+	bAiming = false;
+}
+
+ABonedShooterBotController::ABonedShooterBotController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	bWantsPlayerState = true;
+}
+
+void ABonedShooterBotController::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// AController only wants a player state, AAIController and APlayerController are the ones creating it.
+	// Bots need one like players do, their weapons and shots are keyed by the player id.
+	if (bWantsPlayerState && !IsPendingKill() && GetNetMode() != NM_Client)
+	{
+		InitPlayerState();
+	}
+}
+
+void ABonedShooterBotController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	Brain.Tick(this, Cast<ABonedShooterCharacter>(GetPawn()), DeltaSeconds);
+}
+
+void ABonedShooterBotController::OnUnPossess()
+{
+	Brain.Stop(Cast<ABonedShooterCharacter>(GetPawn()));
+
+	Super::OnUnPossess();
+}
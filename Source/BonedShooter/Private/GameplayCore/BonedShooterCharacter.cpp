@@ -1,21 +1,30 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "GameplayCore/BonedShooterCharacter.h"
+#include "BonedShooter.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Kismet/KismetMathLibrary.h"
 
+#include "GameplayCore/AnimationBudgetSubsystem.h"
+#include "GameplayCore/BonedShooterCharacterMovementComponent.h"
+#include "GameplayCore/LagCompensationSubsystem.h"
+#include "Weapon/AimingComponent.h"
 #include "Weapon/WeaponActor.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 //////////////////////////////////////////////////////////////////////////
 // ABonedShooterCharacter
 
-ABonedShooterCharacter::ABonedShooterCharacter()
+ABonedShooterCharacter::ABonedShooterCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UBonedShooterCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -26,6 +35,16 @@ ABonedShooterCharacter::ABonedShooterCharacter()
 	BaseTurnRate = 45.f;
 	BaseLookUpRate = 45.f;
 
+	CalculatedSpread = 0.f;
+
+	AimReplicationThreshold = 0.5f;
+	AimInterpolationSpeed = 15.f;
+
+	// Adaptive net update frequency moves between these on the default net driver path. The replication graph only
+	// reads NetUpdateFrequency, as a fixed period in server frames.
+	NetUpdateFrequency = 66.f;
+	MinNetUpdateFrequency = 10.f;
+
 	// Don't rotate when the controller rotates. Let that just affect the camera.
 	bUseControllerRotationPitch = false;
 	bUseControllerRotationYaw = false;
@@ -49,6 +68,8 @@ ABonedShooterCharacter::ABonedShooterCharacter()
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
+	AimingComponent = CreateDefaultSubobject<UAimingComponent>(TEXT("AimingComponent"));
+
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
 }
@@ -59,26 +80,75 @@ AWeaponActor* ABonedShooterCharacter::GetWeaponActor()
 	return CurrentWeapon;
 }
 
+float ABonedShooterCharacter::GetCalculatedSpread() const
+{
+	return CurrentWeapon ? CurrentWeapon->GetCurrentSpread() : 0.f;
+}
+
 void ABonedShooterCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 	// Spawn and Attach weapon to the Character. Only on server.
 	if (HasAuthority() && WeaponClass != nullptr)
 	{
+		BONEDSHOOTER_SCOPE(SpawnWeapon);
+
 		FActorSpawnParameters SpawnParams;
 		SpawnParams.Owner = this;
 		SpawnParams.Instigator = this;
 		CurrentWeapon = GetWorld()->SpawnActor<AWeaponActor>(WeaponClass, SpawnParams);
+		MARK_PROPERTY_DIRTY_FROM_NAME(ABonedShooterCharacter, CurrentWeapon, this);
 		if (CurrentWeapon)
 		{
 			CurrentWeapon->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, WeaponSocketName);
 		}
 	}
+
+	// Keep a hitbox history on the server so shots can be checked against what the shooter saw
+	if (HasAuthority())
+	{
+		if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+		{
+			LagCompensation->RegisterCharacter(this);
+		}
+	}
+
+	// Remote players on clients animate as much as the animation budget allows
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		if (UAnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UAnimationBudgetSubsystem>())
+		{
+			AnimationBudget->RegisterCharacter(this);
+		}
+	}
+}
+
+void ABonedShooterCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UAnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UAnimationBudgetSubsystem>())
+	{
+		AnimationBudget->UnregisterCharacter(this);
+	}
+
+	if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void ABonedShooterCharacter::Tick(float DeltaSeconds)
 {
-	Super::Tick(DeltaSeconds);		
+	Super::Tick(DeltaSeconds);
+
+	CalculatedSpread = GetCalculatedSpread();
+
+	// Aim arrives at a lower rate and in coarse steps, ease into it so the aim offset doesn't stutter
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		TargetAimRotation = FMath::RInterpTo(TargetAimRotation, ReplicatedAimRotation.ToRotator(), DeltaSeconds, AimInterpolationSpeed);
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -125,37 +195,36 @@ void ABonedShooterCharacter::LookUpAtRate(float Rate)
 void ABonedShooterCharacter::InputTurn(float Rate)
 {
 	AddControllerYawInput(Rate);
+	// Remote players' aim reaches the server with their moves, see UBonedShooterCharacterMovementComponent
 	if (IsLocallyControlled())
-		TargetAimRotation = GetControlRotation();
-	
-	ReplicateAimOffset();
+		SetTargetAimRotation(GetControlRotation());
 }
 
 void ABonedShooterCharacter::InputLookUp(float Rate)
 {
 	AddControllerPitchInput(Rate);
 	if (IsLocallyControlled())
-		TargetAimRotation = GetControlRotation();
-	ReplicateAimOffset();
+		SetTargetAimRotation(GetControlRotation());
 }
 
-void ABonedShooterCharacter::ReplicateAimOffset()
+void ABonedShooterCharacter::SetTargetAimRotation(const FRotator& NewAimRotation)
 {
+	BONEDSHOOTER_SCOPE(ReplicateAim);
+
+	TargetAimRotation = NewAimRotation;
+
 	if (HasAuthority())
 	{
-		TargetAimRotation = GetControlRotation();
-	}
-	else
-	{
-		SetRemoteControlRotation();
+		const FQuantizedAimRotation NewReplicatedAim(NewAimRotation);
+		if (NewReplicatedAim.DiffersFrom(ReplicatedAimRotation, AimReplicationThreshold))
+		{
+			ReplicatedAimRotation = NewReplicatedAim;
+			MARK_PROPERTY_DIRTY_FROM_NAME(ABonedShooterCharacter, ReplicatedAimRotation, this);
+			BONEDSHOOTER_COUNT(AimUpdates, 1);
+		}
 	}
 }
 
-void ABonedShooterCharacter::SetRemoteControlRotation_Implementation()
-{
-	ReplicateAimOffset();
-}
-
 void ABonedShooterCharacter::MoveForward(float Value)
 {
 	if ((Controller != nullptr) && (Value != 0.0f))
@@ -189,10 +258,11 @@ void ABonedShooterCharacter::StartAiming_Implementation()
 {
 	if (HasAuthority())
 	{
-		bIsAiming = true;
+		SetIsAiming(true);
 	}
 	else
 	{
+		BONEDSHOOTER_COUNT(AimRPCs, 1);
 		ServerStartAim();
 	}
 }
@@ -201,14 +271,116 @@ void ABonedShooterCharacter::StopAiming_Implementation()
 {
 	if (HasAuthority())
 	{
-		bIsAiming = false;
+		SetIsAiming(false);
 	}
 	else
 	{
+		BONEDSHOOTER_COUNT(AimRPCs, 1);
 		ServerStopAim();
 	}
 }
 
+void ABonedShooterCharacter::SetIsAiming(bool bNewIsAiming)
+{
+	bIsAiming = bNewIsAiming;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ABonedShooterCharacter, bIsAiming, this);
+
+	// Shots and their acks travel on the weapon's channel, keep it open while it can fire
+	if (CurrentWeapon && HasAuthority())
+	{
+		CurrentWeapon->SetReplicationAwake(bNewIsAiming);
+	}
+	UpdateAimingComponentActive();
+}
+
+void ABonedShooterCharacter::OnRep_IsAiming()
+{
+	UpdateAimingComponentActive();
+}
+
+void ABonedShooterCharacter::UpdateAimingComponentActive()
+{
+	if (AimingComponent)
+	{
+		AimingComponent->SetAimingActive(bIsAiming && IsLocallyControlled());
+	}
+}
+
+void ABonedShooterCharacter::SetBoneScale(FName BoneName, float Scale)
+{
+	const int32 BoneIndex = GetMesh()->GetBoneIndex(BoneName);
+	if (!HasAuthority() || BoneIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	FReplicatedBoneScale NewBoneScale;
+	NewBoneScale.BoneIndex = BoneIndex;
+	NewBoneScale.SetScale(Scale);
+
+	const int32 ExistingIndex = BoneScales.IndexOfByPredicate([BoneIndex](const FReplicatedBoneScale& BoneScale) { return BoneScale.BoneIndex == BoneIndex; });
+	if (NewBoneScale.QuantizedScale == 100)
+	{
+		if (ExistingIndex == INDEX_NONE)
+		{
+			return;
+		}
+		BoneScales.RemoveAtSwap(ExistingIndex);
+	}
+	else if (ExistingIndex == INDEX_NONE)
+	{
+		BoneScales.Add(NewBoneScale);
+	}
+	else if (BoneScales[ExistingIndex].QuantizedScale != NewBoneScale.QuantizedScale)
+	{
+		BoneScales[ExistingIndex] = NewBoneScale;
+	}
+	else
+	{
+		return;
+	}
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(ABonedShooterCharacter, BoneScales, this);
+	OnRep_BoneScales();
+}
+
+void ABonedShooterCharacter::OnRep_BoneScales()
+{
+	++BoneScalesRevision;
+	ApplyBoneScalesToPhysics();
+}
+
+void ABonedShooterCharacter::ApplyBoneScalesToPhysics()
+{
+	USkeletalMeshComponent* SkeletalMesh = GetMesh();
+	if (SkeletalMesh == nullptr || SkeletalMesh->SkeletalMesh == nullptr)
+	{
+		return;
+	}
+
+	// A body is scaled by its own bone and by every scaled ancestor, like the animation does
+	const FReferenceSkeleton& RefSkeleton = SkeletalMesh->SkeletalMesh->RefSkeleton;
+	const FVector ComponentScale = SkeletalMesh->GetComponentScale();
+	for (FBodyInstance* Body : SkeletalMesh->Bodies)
+	{
+		if (Body == nullptr)
+		{
+			continue;
+		}
+
+		float Scale = 1.f;
+		for (int32 BoneIndex = Body->InstanceBoneIndex; BoneIndex != INDEX_NONE; BoneIndex = RefSkeleton.GetParentIndex(BoneIndex))
+		{
+			const FReplicatedBoneScale* BoneScale = BoneScales.FindByPredicate([BoneIndex](const FReplicatedBoneScale& Entry) { return Entry.BoneIndex == BoneIndex; });
+			if (BoneScale)
+			{
+				Scale *= BoneScale->GetScale();
+			}
+		}
+		Body->UpdateBodyScale(ComponentScale * Scale);
+	}
+}
+
 void ABonedShooterCharacter::ServerStopAim_Implementation()
 {
 	StopAiming();
@@ -244,8 +416,13 @@ void ABonedShooterCharacter::GetLifetimeReplicatedProps(TArray< FLifetimePropert
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ABonedShooterCharacter, CurrentWeapon);
-	DOREPLIFETIME(ABonedShooterCharacter, bIsAiming);
-	DOREPLIFETIME_CONDITION(ABonedShooterCharacter, TargetAimRotation, COND_SimulatedOnly );
-	DOREPLIFETIME(ABonedShooterCharacter, CalculatedSpread);
+	// Push model: only properties marked dirty since the last update are compared
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ABonedShooterCharacter, CurrentWeapon, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ABonedShooterCharacter, bIsAiming, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(ABonedShooterCharacter, BoneScales, Params);
+
+	Params.Condition = COND_SimulatedOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ABonedShooterCharacter, ReplicatedAimRotation, Params);
 }
\ No newline at end of file
@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayCore/BonedShooterCharacterMovementComponent.h"
+
+#include "GameplayCore/BonedShooterCharacter.h"
+
+void UBonedShooterCharacterMovementComponent::ServerMove_PerformMovement(const FCharacterNetworkMoveData& MoveData)
+{
+	Super::ServerMove_PerformMovement(MoveData);
+
+	// The server takes the timestamp of every move it accepts, moves it rejected as too old don't get to aim either
+	const FNetworkPredictionData_Server_Character* ServerData = GetPredictionData_Server_Character();
+	if (ServerData == nullptr || ServerData->CurrentClientTimeStamp != MoveData.TimeStamp)
+	{
+		return;
+	}
+
+	if (ABonedShooterCharacter* BonedShooterCharacter = Cast<ABonedShooterCharacter>(CharacterOwner))
+	{
+		BonedShooterCharacter->SetTargetAimRotation(MoveData.ControlRotation);
+	}
+}
@@ -2,6 +2,12 @@
 
 #include "GameplayCore/BonedShooterGameMode.h"
 #include "GameplayCore/BonedShooterCharacter.h"
+#include "GameplayCore/BonedShooterGameStateBase.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/NetworkObjectList.h"
 #include "UObject/ConstructorHelpers.h"
 
 ABonedShooterGameMode::ABonedShooterGameMode()
@@ -12,4 +18,31 @@ ABonedShooterGameMode::ABonedShooterGameMode()
 	// {
 	// 	DefaultPawnClass = PlayerPawnBPClass.Class;
 	// }
+
+	// Carries the session id of the shot telemetry
+	GameStateClass = ABonedShooterGameStateBase::StaticClass();
 }
+
+static FAutoConsoleCommandWithWorld GDumpNetDormancyCommand(
+	TEXT("BonedShooter.DumpNetDormancy"),
+	TEXT("Server: logs, for every client connection, how many actor channels are open and how many actors are dormant."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		if (NetDriver == nullptr || !NetDriver->IsServer())
+		{
+			return;
+		}
+
+		int32 TotalActive = 0;
+		int32 TotalDormant = 0;
+		for (UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			const int32 NumActive = Connection->ActorChannelsNum();
+			const int32 NumDormant = NetDriver->GetNetworkObjectList().GetNumDormantActorsForConnection(Connection);
+			UE_LOG(LogTemp, Log, TEXT("Net dormancy: %s active %d, dormant %d"), *Connection->LowLevelGetRemoteAddress(), NumActive, NumDormant);
+			TotalActive += NumActive;
+			TotalDormant += NumDormant;
+		}
+		UE_LOG(LogTemp, Log, TEXT("Net dormancy: %d connections, active %d, dormant %d"), NetDriver->ClientConnections.Num(), TotalActive, TotalDormant);
+	}));
@@ -3,3 +3,32 @@
 
 #include "GameplayCore/BonedShooterGameStateBase.h"
 
+#include "BonedShooter.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+void ABonedShooterGameStateBase::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	if (HasAuthority())
+	{
+		// 0 is what clients read until the id replicates
+		do
+		{
+			SessionId = (int32)BonedShooterRand32();
+		}
+		while (SessionId == 0);
+		MARK_PROPERTY_DIRTY_FROM_NAME(ABonedShooterGameStateBase, SessionId, this);
+	}
+}
+
+void ABonedShooterGameStateBase::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Push model: set once when the match starts
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ABonedShooterGameStateBase, SessionId, Params);
+}
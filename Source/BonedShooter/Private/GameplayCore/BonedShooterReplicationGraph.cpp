@@ -0,0 +1,250 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayCore/BonedShooterReplicationGraph.h"
+
+#include "Engine/LevelScriptActor.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "GameplayCore/BonedShooterCharacter.h"
+#include "HAL/IConsoleManager.h"
+#include "ReplicationGraphTypes.h"
+#include "UObject/UObjectIterator.h"
+#include "Weapon/Bullet.h"
+#include "Weapon/WeaponActor.h"
+
+void UBonedShooterReplicationGraphNode_AlwaysRelevant_ForConnection::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		ReplicationActorList.ConditionalAdd(Viewer.InViewer);
+		ReplicationActorList.ConditionalAdd(Viewer.ViewTarget);
+
+		if (const APlayerController* PlayerController = Cast<APlayerController>(Viewer.InViewer))
+		{
+			ReplicationActorList.ConditionalAdd(PlayerController->PlayerState);
+
+			// The weapon is a dependent of the pawn for everyone else, its owner gets it no matter what
+			if (ABonedShooterCharacter* Character = Cast<ABonedShooterCharacter>(PlayerController->GetPawn()))
+			{
+				ReplicationActorList.ConditionalAdd(Character);
+				ReplicationActorList.ConditionalAdd(Character->GetWeaponActor());
+			}
+		}
+	}
+
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+}
+
+EBonedShooterClassRepPolicy UBonedShooterReplicationGraph::GetClassPolicy(UClass* Class)
+{
+	if (const EBonedShooterClassRepPolicy* Policy = ClassRepPolicies.Get(Class))
+	{
+		return *Policy;
+	}
+
+	// Anything else is routed from its defaults, so adding and removing always agree
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+	if (ActorCDO->bAlwaysRelevant)
+	{
+		return EBonedShooterClassRepPolicy::RelevantAllConnections;
+	}
+	if (ActorCDO->bOnlyRelevantToOwner)
+	{
+		return EBonedShooterClassRepPolicy::NotRouted;
+	}
+	if (ActorCDO->NetDormancy > DORM_Awake)
+	{
+		return EBonedShooterClassRepPolicy::Spatialize_Dormancy;
+	}
+	return ActorCDO->IsReplicatingMovement() ? EBonedShooterClassRepPolicy::Spatialize_Dynamic : EBonedShooterClassRepPolicy::Spatialize_Static;
+}
+
+void UBonedShooterReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Routing of the classes the defaults would get wrong, the lookup walks up the class hierarchy
+	ClassRepPolicies.Set(AInfo::StaticClass(), EBonedShooterClassRepPolicy::RelevantAllConnections);
+	ClassRepPolicies.Set(ALevelScriptActor::StaticClass(), EBonedShooterClassRepPolicy::NotRouted);
+	ClassRepPolicies.Set(APlayerController::StaticClass(), EBonedShooterClassRepPolicy::NotRouted);
+	ClassRepPolicies.Set(APlayerState::StaticClass(), EBonedShooterClassRepPolicy::RelevantAllConnections);
+	ClassRepPolicies.Set(AGameStateBase::StaticClass(), EBonedShooterClassRepPolicy::RelevantAllConnections);
+	ClassRepPolicies.Set(ABonedShooterCharacter::StaticClass(), EBonedShooterClassRepPolicy::Spatialize_Dynamic);
+	ClassRepPolicies.Set(ABullet::StaticClass(), EBonedShooterClassRepPolicy::Spatialize_Dynamic);
+	ClassRepPolicies.Set(AWeaponActor::StaticClass(), EBonedShooterClassRepPolicy::NotRouted);
+
+	// Every replicated class loaded now gets its own info. Classes loaded later use the info of their closest parent.
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+		if (ActorCDO == nullptr || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+
+		// Leftovers of Blueprint compilation
+		const FString ClassName = Class->GetName();
+		if (ClassName.StartsWith(TEXT("SKEL_")) || ClassName.StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		const EBonedShooterClassRepPolicy Policy = GetClassPolicy(Class);
+		const bool bSpatialize = Policy == EBonedShooterClassRepPolicy::Spatialize_Dynamic
+			|| Policy == EBonedShooterClassRepPolicy::Spatialize_Static
+			|| Policy == EBonedShooterClassRepPolicy::Spatialize_Dormancy;
+
+		FClassReplicationInfo ClassInfo;
+		InitClassReplicationInfo(ClassInfo, Class, bSpatialize);
+
+		// The configured values win over what the defaults of subclasses say
+		if (Class->IsChildOf(ABonedShooterCharacter::StaticClass()))
+		{
+			ClassInfo.SetCullDistanceSquared(FMath::Square(CharacterCullDistance));
+		}
+		else if (Class->IsChildOf(ABullet::StaticClass()))
+		{
+			ClassInfo.SetCullDistanceSquared(FMath::Square(BulletCullDistance));
+		}
+		else if (Class->IsChildOf(APlayerState::StaticClass()))
+		{
+			ClassInfo.ReplicationPeriodFrame = FMath::Max(PlayerStateReplicationPeriodFrame, 1);
+		}
+
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UBonedShooterReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool bSpatialize) const
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+	if (bSpatialize)
+	{
+		Info.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+	}
+
+	// The graph replicates on server frames, NetUpdateFrequency becomes a fixed period
+	const float ServerMaxTickRate = NetDriver ? NetDriver->NetServerMaxTickRate : 30.f;
+	Info.ReplicationPeriodFrame = FMath::Max<uint32>((uint32)FMath::RoundToFloat(ServerMaxTickRate / FMath::Max(ActorCDO->NetUpdateFrequency, 1.f)), 1);
+}
+
+void UBonedShooterReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = GridSpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UBonedShooterReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UBonedShooterReplicationGraphNode_AlwaysRelevant_ForConnection* ConnectionNode = CreateNewNode<UBonedShooterReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(ConnectionNode, RepGraphConnection);
+}
+
+void UBonedShooterReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	// The weapon replicates along with its character, to whoever the character replicates to
+	if (AWeaponActor* Weapon = Cast<AWeaponActor>(ActorInfo.GetActor()))
+	{
+		if (AActor* WeaponOwner = Weapon->GetOwner())
+		{
+			GlobalActorReplicationInfoMap.AddDependentActor(WeaponOwner, Weapon);
+		}
+		return;
+	}
+
+	switch (GetClassPolicy(ActorInfo.Class))
+	{
+	case EBonedShooterClassRepPolicy::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case EBonedShooterClassRepPolicy::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case EBonedShooterClassRepPolicy::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case EBonedShooterClassRepPolicy::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void UBonedShooterReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	if (AWeaponActor* Weapon = Cast<AWeaponActor>(ActorInfo.GetActor()))
+	{
+		if (AActor* WeaponOwner = Weapon->GetOwner())
+		{
+			GlobalActorReplicationInfoMap.RemoveDependentActor(WeaponOwner, Weapon);
+		}
+		return;
+	}
+
+	switch (GetClassPolicy(ActorInfo.Class))
+	{
+	case EBonedShooterClassRepPolicy::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case EBonedShooterClassRepPolicy::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case EBonedShooterClassRepPolicy::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case EBonedShooterClassRepPolicy::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+int32 UBonedShooterReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+	const int32 Result = Super::ServerReplicateActors(DeltaSeconds);
+	LastReplicationSeconds = FPlatformTime::Seconds() - StartSeconds;
+	ReplicationSeconds += LastReplicationSeconds;
+	++ReplicationFrames;
+	return Result;
+}
+
+void UBonedShooterReplicationGraph::DumpReplicationTime()
+{
+	const int32 NumConnections = NetDriver ? NetDriver->ClientConnections.Num() : 0;
+	UE_LOG(LogTemp, Log, TEXT("Replication graph: %d connections, %d frames, %.3f ms per frame"),
+		NumConnections, ReplicationFrames, ReplicationFrames > 0 ? ReplicationSeconds * 1000.0 / ReplicationFrames : 0.0);
+
+	ReplicationSeconds = 0.0;
+	ReplicationFrames = 0;
+}
+
+static FAutoConsoleCommandWithWorld GDumpReplicationTimeCommand(
+	TEXT("BonedShooter.DumpReplicationTime"),
+	TEXT("Server: logs the average replication graph time per frame since the last call, and resets it."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		if (UBonedShooterReplicationGraph* Graph = NetDriver ? Cast<UBonedShooterReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr)
+		{
+			Graph->DumpReplicationTime();
+		}
+	}));
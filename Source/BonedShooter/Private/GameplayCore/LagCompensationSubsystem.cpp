@@ -0,0 +1,331 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayCore/LagCompensationSubsystem.h"
+
+#include "BonedShooter.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameplayCore/BonedShooterCharacter.h"
+
+bool ULagCompensationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && (World->WorldType == EWorldType::Game || World->WorldType == EWorldType::PIE);
+}
+
+void ULagCompensationSubsystem::Deinitialize()
+{
+	Histories.Empty();
+	HistoryIndexByCharacter.Empty();
+
+	Super::Deinitialize();
+}
+
+bool ULagCompensationSubsystem::IsTickable() const
+{
+	return !IsTemplate() && Histories.Num() > 0;
+}
+
+TStatId ULagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULagCompensationSubsystem, STATGROUP_BonedShooter);
+}
+
+float ULagCompensationSubsystem::GetLagCompensationTime(const UWorld* World)
+{
+	const AGameStateBase* GameState = World ? World->GetGameState() : nullptr;
+	return GameState ? GameState->GetServerWorldTimeSeconds() : (World ? World->GetTimeSeconds() : 0.f);
+}
+
+float ULagCompensationSubsystem::GetClientViewTime(float ClientFireTime, const UNetConnection* Connection) const
+{
+	if (Connection == nullptr)
+	{
+		return ClientFireTime;
+	}
+
+	// The client's server clock, GetServerWorldTimeSeconds, is set from replicated values without any correction for
+	// latency: it already runs half a round trip behind, like the replicated state it draws. Only the smoothing is left.
+	return ClientFireTime - InterpolationDelay;
+}
+
+void ULagCompensationSubsystem::RegisterCharacter(ABonedShooterCharacter* Character)
+{
+	if (Character == nullptr || HistoryIndexByCharacter.Contains(Character))
+	{
+		return;
+	}
+
+	FLagCompensationHistory& History = Histories.AddDefaulted_GetRef();
+	History.Character = Character;
+
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+	History.CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	History.CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+
+	// Name lookups happen once here, recording only deals with indices
+	if (USkeletalMeshComponent* Mesh = Character->GetMesh())
+	{
+		// Nothing renders on a dedicated server, without this the bones recorded would never move
+		Mesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+
+		for (const FName& BoneName : TrackedBones)
+		{
+			const int32 BoneIndex = Mesh->GetBoneIndex(BoneName);
+			if (BoneIndex != INDEX_NONE && History.BoneIndices.Num() < LAG_COMPENSATION_MAX_BONES)
+			{
+				History.BoneIndices.Add(BoneIndex);
+			}
+		}
+	}
+
+	const int32 Capacity = FMath::Max(HistoryCapacity, 2);
+	History.Times.SetNumZeroed(Capacity);
+	History.CapsuleLocations.SetNumZeroed(Capacity);
+	History.BoneTransforms.SetNum(Capacity * History.BoneIndices.Num());
+
+	HistoryIndexByCharacter.Add(Character, Histories.Num() - 1);
+}
+
+void ULagCompensationSubsystem::UnregisterCharacter(ABonedShooterCharacter* Character)
+{
+	if (const int32* Index = HistoryIndexByCharacter.Find(Character))
+	{
+		RemoveHistoryAt(*Index);
+	}
+}
+
+void ULagCompensationSubsystem::RemoveHistoryAt(int32 Index)
+{
+	// The character may already be gone, so find the entry by value rather than by key
+	for (auto It = HistoryIndexByCharacter.CreateIterator(); It; ++It)
+	{
+		if (It.Value() == Index)
+		{
+			It.RemoveCurrent();
+			break;
+		}
+	}
+
+	Histories.RemoveAtSwap(Index, 1, false);
+	if (Histories.IsValidIndex(Index))
+	{
+		HistoryIndexByCharacter.Add(Histories[Index].Character.Get(), Index);
+	}
+}
+
+void ULagCompensationSubsystem::Tick(float DeltaTime)
+{
+	const float Now = GetLagCompensationTime(GetWorld());
+
+	for (int32 Index = Histories.Num() - 1; Index >= 0; --Index)
+	{
+		FLagCompensationHistory& History = Histories[Index];
+		if (!History.Character.IsValid())
+		{
+			// Character went away without unregistering
+			RemoveHistoryAt(Index);
+			continue;
+		}
+		RecordFrame(History, Now);
+	}
+}
+
+void ULagCompensationSubsystem::RecordFrame(FLagCompensationHistory& History, float Now)
+{
+	const ABonedShooterCharacter* Character = History.Character.Get();
+	const int32 Slot = History.Head;
+	const int32 NumBones = History.BoneIndices.Num();
+
+	History.Times[Slot] = Now;
+	History.CapsuleLocations[Slot] = Character->GetActorLocation();
+
+	if (NumBones > 0)
+	{
+		const USkeletalMeshComponent* Mesh = Character->GetMesh();
+		FTransform* SlotBones = &History.BoneTransforms[Slot * NumBones];
+		for (int32 Bone = 0; Bone < NumBones; ++Bone)
+		{
+			SlotBones[Bone] = Mesh->GetBoneTransform(History.BoneIndices[Bone]);
+		}
+	}
+
+	History.Head = (History.Head + 1) % History.GetCapacity();
+	History.Count = FMath::Min(History.Count + 1, History.GetCapacity());
+}
+
+const FLagCompensationHistory* ULagCompensationSubsystem::FindHistory(const ABonedShooterCharacter* Character) const
+{
+	const int32* Index = HistoryIndexByCharacter.Find(Character);
+	return Index ? &Histories[*Index] : nullptr;
+}
+
+void ULagCompensationSubsystem::SamplePose(const FLagCompensationHistory& History, int32 LogicalIndex, float Alpha, FLagCompensatedPose& OutPose)
+{
+	const int32 SlotA = History.ToSlot(LogicalIndex);
+	const int32 SlotB = History.ToSlot(FMath::Min(LogicalIndex + 1, History.Count - 1));
+	const int32 NumBones = History.BoneIndices.Num();
+
+	OutPose.CapsuleRadius = History.CapsuleRadius;
+	OutPose.CapsuleHalfHeight = History.CapsuleHalfHeight;
+	OutPose.CapsuleLocation = FMath::Lerp(History.CapsuleLocations[SlotA], History.CapsuleLocations[SlotB], Alpha);
+
+	OutPose.BoneTransforms.SetNum(NumBones, false);
+	for (int32 Bone = 0; Bone < NumBones; ++Bone)
+	{
+		OutPose.BoneTransforms[Bone].Blend(History.BoneTransforms[SlotA * NumBones + Bone], History.BoneTransforms[SlotB * NumBones + Bone], Alpha);
+	}
+}
+
+bool ULagCompensationSubsystem::GetRewoundPose(const ABonedShooterCharacter* Character, float Timestamp, FLagCompensatedPose& OutPose) const
+{
+	const FLagCompensationHistory* History = FindHistory(Character);
+	if (History == nullptr || History->Count == 0)
+	{
+		return false;
+	}
+
+	// Binary search for the newest frame recorded at or before Timestamp
+	int32 Low = 0;
+	int32 High = History->Count - 1;
+	if (Timestamp <= History->Times[History->ToSlot(0)])
+	{
+		High = 0;
+	}
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High + 1) / 2;
+		if (History->Times[History->ToSlot(Mid)] <= Timestamp)
+		{
+			Low = Mid;
+		}
+		else
+		{
+			High = Mid - 1;
+		}
+	}
+
+	float Alpha = 0.f;
+	if (Low + 1 < History->Count)
+	{
+		const float TimeA = History->Times[History->ToSlot(Low)];
+		const float TimeB = History->Times[History->ToSlot(Low + 1)];
+		Alpha = TimeB > TimeA ? FMath::Clamp((Timestamp - TimeA) / (TimeB - TimeA), 0.f, 1.f) : 0.f;
+	}
+
+	SamplePose(*History, Low, Alpha, OutPose);
+	return true;
+}
+
+bool ULagCompensationSubsystem::TraceAgainstPose(const FLagCompensatedPose& Pose, const FVector& Start, const FVector& End, int32& OutBone, FVector& OutPoint) const
+{
+	// Cheap reject against the capsule first
+	const FVector CapsuleAxis(0.f, 0.f, FMath::Max(Pose.CapsuleHalfHeight - Pose.CapsuleRadius, 0.f));
+	FVector PointOnRay;
+	FVector PointOnCapsule;
+	FMath::SegmentDistToSegmentSafe(Start, End, Pose.CapsuleLocation - CapsuleAxis, Pose.CapsuleLocation + CapsuleAxis, PointOnRay, PointOnCapsule);
+	if (FVector::DistSquared(PointOnRay, PointOnCapsule) > FMath::Square(Pose.CapsuleRadius))
+	{
+		return false;
+	}
+
+	if (Pose.BoneTransforms.Num() == 0)
+	{
+		OutBone = INDEX_NONE;
+		OutPoint = PointOnRay;
+		return true;
+	}
+
+	// The capsule is coarse, only a bone sphere counts as a hit
+	float BestDistanceSquared = MAX_flt;
+	OutBone = INDEX_NONE;
+	for (int32 Bone = 0; Bone < Pose.BoneTransforms.Num(); ++Bone)
+	{
+		// Recorded transforms carry the bone scaling, hit spheres grow and shrink with the bones
+		const FVector BoneLocation = Pose.BoneTransforms[Bone].GetLocation();
+		const float HitRadius = BoneHitRadius * Pose.BoneTransforms[Bone].GetMaximumAxisScale();
+		const FVector ClosestPoint = FMath::ClosestPointOnSegment(BoneLocation, Start, End);
+		if (FVector::DistSquared(ClosestPoint, BoneLocation) <= FMath::Square(HitRadius))
+		{
+			const float DistanceSquared = FVector::DistSquared(Start, ClosestPoint);
+			if (DistanceSquared < BestDistanceSquared)
+			{
+				BestDistanceSquared = DistanceSquared;
+				OutBone = Bone;
+				OutPoint = ClosestPoint;
+			}
+		}
+	}
+	return OutBone != INDEX_NONE;
+}
+
+FVector ULagCompensationSubsystem::ResolveShotDestination(const FVector& Start, const FVector& End, float Timestamp, const AActor* Shooter) const
+{
+	UWorld* World = GetWorld();
+	const float Now = GetLagCompensationTime(World);
+	const float RewindTime = FMath::Clamp(Timestamp, Now - MaxRewindTime, Now);
+
+	const FLagCompensationHistory* HitHistory = nullptr;
+	FLagCompensatedPose HitPose;
+	FVector HitPoint = End;
+	int32 HitBone = INDEX_NONE;
+	float BestDistanceSquared = MAX_flt;
+
+	// The client's trace stops on the surface of the body, probe a bit further so the bone spheres are reached
+	const FVector ProbeEnd = End + (End - Start).GetSafeNormal() * BoneHitRadius * 2.f;
+
+	FLagCompensatedPose Pose;
+	for (const FLagCompensationHistory& History : Histories)
+	{
+		if (History.Count == 0 || History.Character.Get() == Shooter)
+		{
+			continue;
+		}
+
+		int32 Bone;
+		FVector Point;
+		if (GetRewoundPose(History.Character.Get(), RewindTime, Pose) && TraceAgainstPose(Pose, Start, ProbeEnd, Bone, Point))
+		{
+			const float DistanceSquared = FVector::DistSquared(Start, Point);
+			if (DistanceSquared < BestDistanceSquared)
+			{
+				BestDistanceSquared = DistanceSquared;
+				HitHistory = &History;
+				HitPose = Pose;
+				HitPoint = Point;
+				HitBone = Bone;
+			}
+		}
+	}
+
+	if (HitHistory == nullptr)
+	{
+		return End;
+	}
+
+	// Level geometry doesn't move, a present-time test tells whether the client shot through a wall
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LagCompensationWallCheck), false, Shooter);
+	FHitResult BlockingHit;
+	if (World->LineTraceSingleByObjectType(BlockingHit, Start, HitPoint, FCollisionObjectQueryParams(ECC_WorldStatic), QueryParams))
+	{
+		return BlockingHit.ImpactPoint;
+	}
+
+	// Aim at the same spot of the body, where the body is now
+	FLagCompensatedPose PresentPose;
+	SamplePose(*HitHistory, HitHistory->Count - 1, 0.f, PresentPose);
+	if (HitBone != INDEX_NONE)
+	{
+		const FVector LocalPoint = HitPose.BoneTransforms[HitBone].InverseTransformPosition(HitPoint);
+		return PresentPose.BoneTransforms[HitBone].TransformPosition(LocalPoint);
+	}
+	return HitPoint + (PresentPose.CapsuleLocation - HitPose.CapsuleLocation);
+}
@@ -0,0 +1,426 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayCore/LoadTestSubsystem.h"
+
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameplayCore/BonedShooterCharacter.h"
+#include "GameplayCore/BonedShooterReplicationGraph.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Weapon/ProjectilePoolSubsystem.h"
+#include "Weapon/ProjectileSimulationSubsystem.h"
+
+// Distance between two bots at spawn, enough for capsules not to push each other
+static constexpr float BotSpacing = 200.f;
+
+bool ULoadTestSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && (World->WorldType == EWorldType::Game || World->WorldType == EWorldType::PIE);
+}
+
+void ULoadTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	FString CommandLineBotList;
+	if (FParse::Value(CommandLine, TEXT("LoadTestBots="), CommandLineBotList, false))
+	{
+		CommandLineBots = ParseBotCounts(CommandLineBotList);
+		CommandLineSeconds = 60.f;
+		FParse::Value(CommandLine, TEXT("LoadTestDuration="), CommandLineSeconds);
+		FParse::Value(CommandLine, TEXT("LoadTestClients="), CommandLineClients);
+		bStartFromCommandLinePending = true;
+	}
+	bDriveLocalPlayer = FParse::Param(CommandLine, TEXT("LoadTestClient"));
+	LocalPlayerBrain.Init(FPlatformProcess::GetCurrentProcessId());
+
+	WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &ULoadTestSubsystem::OnWorldTickStart);
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ULoadTestSubsystem::OnWorldPostActorTick);
+	PostTickFlushHandle = GetWorld()->OnPostTickFlush().AddUObject(this, &ULoadTestSubsystem::OnPostTickFlush);
+}
+
+void ULoadTestSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	GetWorld()->OnPostTickFlush().Remove(PostTickFlushHandle);
+
+	// Don't leave headless clients behind when the server goes away mid-run
+	for (FProcHandle& ClientProcess : ClientProcesses)
+	{
+		FPlatformProcess::TerminateProc(ClientProcess, true);
+		FPlatformProcess::CloseProc(ClientProcess);
+	}
+	ClientProcesses.Empty();
+	Bots.Empty();
+	Samples.Empty();
+	PendingBotCounts.Empty();
+
+	Super::Deinitialize();
+}
+
+bool ULoadTestSubsystem::IsTickable() const
+{
+	return !IsTemplate() && (bRunning || bStartFromCommandLinePending || bDriveLocalPlayer);
+}
+
+TStatId ULoadTestSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULoadTestSubsystem, STATGROUP_Tickables);
+}
+
+void ULoadTestSubsystem::Tick(float DeltaTime)
+{
+	UWorld* World = GetWorld();
+
+	if (bDriveLocalPlayer)
+	{
+		APlayerController* PlayerController = World->GetFirstPlayerController();
+		LocalPlayerBrain.Tick(PlayerController, PlayerController ? Cast<ABonedShooterCharacter>(PlayerController->GetPawn()) : nullptr, DeltaTime);
+	}
+
+	if (bStartFromCommandLinePending && World->HasBegunPlay())
+	{
+		bStartFromCommandLinePending = false;
+		bExitWhenDone = true;
+		StartLoadTestSeries(CommandLineBots, CommandLineSeconds, CommandLineClients);
+	}
+
+	if (bRunning)
+	{
+		ElapsedTime += DeltaTime;
+		if (ElapsedTime > WarmupSeconds)
+		{
+			RecordedSeconds += DeltaTime;
+			if (RecordedSeconds >= RecordSeconds)
+			{
+				FinishLoadTest();
+			}
+		}
+	}
+}
+
+void ULoadTestSubsystem::StartLoadTestSeries(const TArray<int32>& BotCounts, float Seconds, int32 NumClients)
+{
+	if (BotCounts.Num() == 0 || bRunning)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Load test: no bot count given, or already running"));
+		return;
+	}
+
+	PendingBotCounts = BotCounts;
+	PendingBotCounts.RemoveAt(0);
+	StartLoadTest(BotCounts[0], Seconds, NumClients);
+}
+
+TArray<int32> ULoadTestSubsystem::ParseBotCounts(const FString& List)
+{
+	TArray<FString> Entries;
+	List.ParseIntoArray(Entries, TEXT(","));
+
+	TArray<int32> BotCounts;
+	for (const FString& Entry : Entries)
+	{
+		BotCounts.Add(FMath::Max(FCString::Atoi(*Entry), 0));
+	}
+	return BotCounts;
+}
+
+void ULoadTestSubsystem::StartLoadTest(int32 NumBots, float Seconds, int32 NumClients)
+{
+	if (bRunning || GetWorld()->GetAuthGameMode() == nullptr || Seconds <= 0.f)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Load test: can't start, already running or not the server"));
+		return;
+	}
+
+	FString CsvFile = DefaultCsvFile;
+	FParse::Value(FCommandLine::Get(), TEXT("LoadTestCsv="), CsvFile);
+	CsvPath = FPaths::IsRelative(CsvFile) ? FPaths::Combine(FPaths::ProjectSavedDir(), CsvFile) : CsvFile;
+
+	NumBotsRequested = FMath::Max(NumBots, 0);
+	NumClientsRequested = FMath::Max(NumClients, 0);
+	SpawnBots(NumBotsRequested);
+	LaunchClients(NumClientsRequested);
+
+	ElapsedTime = 0.f;
+	RecordSeconds = Seconds;
+	RecordedSeconds = 0.f;
+	RecordedFireBatches = 0;
+	Samples.Reset();
+	Samples.Reserve(FMath::CeilToInt(Seconds * 120.f));
+	OutBytesPerConnectionSum = 0.0;
+	OutBytesPerConnectionCount = 0;
+	PeakOutBytesPerConnection = 0;
+	PeakConnections = 0;
+	bRunning = true;
+
+	UE_LOG(LogTemp, Log, TEXT("Load test: %d bots, %d headless clients, %.0f s after %.0f s of warmup"),
+		Bots.Num(), ClientProcesses.Num(), Seconds, WarmupSeconds);
+}
+
+void ULoadTestSubsystem::SpawnBots(int32 NumBots)
+{
+	UWorld* World = GetWorld();
+	AGameModeBase* GameMode = World->GetAuthGameMode();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	const int32 RowLength = FMath::Max(FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumBots))), 1);
+	for (int32 Index = 0; Index < NumBots; ++Index)
+	{
+		ABonedShooterBotController* Bot = World->SpawnActor<ABonedShooterBotController>(SpawnParams);
+		if (Bot == nullptr)
+		{
+			continue;
+		}
+		Bot->InitBrain(Index + 1);
+
+		// Around the player start instead of on it, so all bots spawn
+		const AActor* PlayerStart = GameMode->FindPlayerStart(Bot);
+		FTransform SpawnTransform = PlayerStart ? PlayerStart->GetActorTransform() : FTransform::Identity;
+		SpawnTransform.AddToTranslation(FVector((Index % RowLength) * BotSpacing, (Index / RowLength) * BotSpacing, 0.f));
+
+		APawn* Pawn = World->SpawnActor<APawn>(GameMode->GetDefaultPawnClassForController(Bot), SpawnTransform, SpawnParams);
+		if (Pawn)
+		{
+			Bot->Possess(Pawn);
+		}
+		Bots.Add(Bot);
+	}
+}
+
+void ULoadTestSubsystem::LaunchClients(int32 NumClients)
+{
+	FString Params = FString::Printf(TEXT("127.0.0.1:%d -LoadTestClient %s"), GetWorld()->URL.Port, *ClientCommandLine);
+#if WITH_EDITOR
+	// Editor binaries need the project and to be told to run the game
+	Params = FString::Printf(TEXT("\"%s\" %s -game"), *FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()), *Params);
+#endif
+
+	for (int32 Index = 0; Index < NumClients; ++Index)
+	{
+		FProcHandle ClientProcess = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Params, true, false, false, nullptr, 0, nullptr, nullptr);
+		if (ClientProcess.IsValid())
+		{
+			ClientProcesses.Add(ClientProcess);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Load test: failed to launch headless client %s %s"), FPlatformProcess::ExecutablePath(), *Params);
+		}
+	}
+}
+
+void ULoadTestSubsystem::FinishLoadTest()
+{
+	bRunning = false;
+	WriteReport();
+
+	for (ABonedShooterBotController* Bot : Bots)
+	{
+		if (IsValid(Bot))
+		{
+			if (APawn* Pawn = Bot->GetPawn())
+			{
+				Bot->UnPossess();
+				Pawn->Destroy();
+			}
+			Bot->Destroy();
+		}
+	}
+	Bots.Empty();
+
+	for (FProcHandle& ClientProcess : ClientProcesses)
+	{
+		FPlatformProcess::TerminateProc(ClientProcess, true);
+		FPlatformProcess::CloseProc(ClientProcess);
+	}
+	ClientProcesses.Empty();
+
+	// Next step of a series, the warmup lets the previous bots go away before recording
+	if (PendingBotCounts.Num() > 0)
+	{
+		const int32 NextBots = PendingBotCounts[0];
+		PendingBotCounts.RemoveAt(0);
+		StartLoadTest(NextBots, RecordSeconds, NumClientsRequested);
+		return;
+	}
+
+	if (bExitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void ULoadTestSubsystem::OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		WorldTickStartSeconds = FPlatformTime::Seconds();
+	}
+}
+
+void ULoadTestSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		PostActorTickSeconds = FPlatformTime::Seconds();
+	}
+}
+
+void ULoadTestSubsystem::OnPostTickFlush()
+{
+	// Last thing of the world tick, every stamp of the frame is in
+	if (!bRunning || ElapsedTime <= WarmupSeconds)
+	{
+		return;
+	}
+
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (Samples.Num() == 0)
+	{
+		FirstRecordedRPCs = NetDriver ? NetDriver->TotalRPCsCalled : 0;
+	}
+
+	FLoadTestSample& Sample = Samples.AddDefaulted_GetRef();
+	Sample.FrameMs = FApp::GetDeltaTime() * 1000.f;
+	Sample.GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Sample.WorldTickMs = (PostActorTickSeconds - WorldTickStartSeconds) * 1000.0;
+	Sample.NetFlushMs = (FPlatformTime::Seconds() - PostActorTickSeconds) * 1000.0;
+	Sample.BulletsAlive = CountBulletsAlive();
+	if (const UBonedShooterReplicationGraph* Graph = NetDriver ? Cast<UBonedShooterReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr)
+	{
+		Sample.ReplicationMs = Graph->GetLastReplicationSeconds() * 1000.0;
+	}
+
+	if (NetDriver)
+	{
+		LastRecordedRPCs = NetDriver->TotalRPCsCalled;
+		PeakConnections = FMath::Max(PeakConnections, NetDriver->ClientConnections.Num());
+		for (const UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			if (Connection)
+			{
+				OutBytesPerConnectionSum += Connection->OutBytesPerSecond;
+				++OutBytesPerConnectionCount;
+				PeakOutBytesPerConnection = FMath::Max(PeakOutBytesPerConnection, Connection->OutBytesPerSecond);
+			}
+		}
+	}
+}
+
+void ULoadTestSubsystem::CountIncomingFireBatch()
+{
+	if (bRunning && ElapsedTime > WarmupSeconds)
+	{
+		++RecordedFireBatches;
+	}
+}
+
+int32 ULoadTestSubsystem::CountBulletsAlive() const
+{
+	int32 BulletsAlive = 0;
+	if (const UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+	{
+		BulletsAlive += Pool->GetNumActive();
+	}
+	if (const UProjectileSimulationSubsystem* Simulation = GetWorld()->GetSubsystem<UProjectileSimulationSubsystem>())
+	{
+		BulletsAlive += Simulation->GetNumProjectiles();
+	}
+	return BulletsAlive;
+}
+
+void ULoadTestSubsystem::WriteReport() const
+{
+	const int32 NumSamples = Samples.Num();
+	if (NumSamples == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Load test: no frame recorded"));
+		return;
+	}
+
+	TArray<float> FrameTimes;
+	FrameTimes.Reserve(NumSamples);
+	double GameThreadMs = 0.0, WorldTickMs = 0.0, NetFlushMs = 0.0, ReplicationMs = 0.0, BulletsAlive = 0.0;
+	int32 PeakBulletsAlive = 0;
+	for (const FLoadTestSample& Sample : Samples)
+	{
+		FrameTimes.Add(Sample.FrameMs);
+		GameThreadMs += Sample.GameThreadMs;
+		WorldTickMs += Sample.WorldTickMs;
+		NetFlushMs += Sample.NetFlushMs;
+		ReplicationMs += Sample.ReplicationMs;
+		BulletsAlive += Sample.BulletsAlive;
+		PeakBulletsAlive = FMath::Max(PeakBulletsAlive, Sample.BulletsAlive);
+	}
+	FrameTimes.Sort();
+	const auto Percentile = [&FrameTimes](float Fraction)
+	{
+		return FrameTimes[FMath::Min(FMath::FloorToInt(Fraction * FrameTimes.Num()), FrameTimes.Num() - 1)];
+	};
+
+	const float RPCsPerSecond = RecordedSeconds > 0.f ? (LastRecordedRPCs - FirstRecordedRPCs) / RecordedSeconds : 0.f;
+	const float FireBatchesPerSecond = RecordedSeconds > 0.f ? RecordedFireBatches / RecordedSeconds : 0.f;
+	const double AverageOutBytesPerConnection = OutBytesPerConnectionCount > 0 ? OutBytesPerConnectionSum / OutBytesPerConnectionCount : 0.0;
+
+	FString Csv;
+	if (!IFileManager::Get().FileExists(*CsvPath))
+	{
+		Csv += TEXT("Date,Map,Bots,Clients,Connections,Seconds,Frames,FrameMsP50,FrameMsP90,FrameMsP99,FrameMsMax,")
+			TEXT("GameThreadMsAvg,WorldTickMsAvg,NetFlushMsAvg,ReplicationMsAvg,BulletsAliveAvg,BulletsAliveMax,OutRPCsPerSec,InFireBatchRPCsPerSec,")
+			TEXT("OutBytesPerSecPerConnectionAvg,OutBytesPerSecPerConnectionMax,PushModel\n");
+	}
+	Csv += FString::Printf(TEXT("%s,%s,%d,%d,%d,%.1f,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f,%d,%.1f,%.1f,%.0f,%d,%d\n"),
+		*FDateTime::Now().ToIso8601(), *GetWorld()->GetMapName(), NumBotsRequested, NumClientsRequested, PeakConnections,
+		RecordedSeconds, NumSamples, Percentile(0.5f), Percentile(0.9f), Percentile(0.99f), FrameTimes.Last(),
+		GameThreadMs / NumSamples, WorldTickMs / NumSamples, NetFlushMs / NumSamples, ReplicationMs / NumSamples, BulletsAlive / NumSamples, PeakBulletsAlive,
+		RPCsPerSecond, FireBatchesPerSecond, AverageOutBytesPerConnection, PeakOutBytesPerConnection, IS_PUSH_MODEL_ENABLED() ? 1 : 0);
+
+	if (FFileHelper::SaveStringToFile(Csv, *CsvPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOG(LogTemp, Log, TEXT("Load test: %d frames, p50 %.2f ms, p99 %.2f ms, report appended to %s"),
+			NumSamples, Percentile(0.5f), Percentile(0.99f), *CsvPath);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Load test: failed to write %s"), *CsvPath);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GStartLoadTestCommand(
+	TEXT("BonedShooter.StartLoadTest"),
+	TEXT("Server: spawns bots and headless clients, records the server frame and network costs, appends them to a CSV.\n")
+	TEXT("Usage: BonedShooter.StartLoadTest [NumBots=32, or a list like 8,16,32] [Seconds=60] [NumClients=0]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		ULoadTestSubsystem* LoadTest = World ? World->GetSubsystem<ULoadTestSubsystem>() : nullptr;
+		if (LoadTest == nullptr)
+		{
+			return;
+		}
+
+		const TArray<int32> BotCounts = Args.Num() > 0 ? ULoadTestSubsystem::ParseBotCounts(Args[0]) : TArray<int32>{ 32 };
+		const float Seconds = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 60.f;
+		const int32 NumClients = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 0;
+		LoadTest->StartLoadTestSeries(BotCounts, Seconds, NumClients);
+	}));
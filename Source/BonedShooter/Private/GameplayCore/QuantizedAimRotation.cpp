@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayCore/QuantizedAimRotation.h"
+
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarAimRotationBits(
+	TEXT("BonedShooter.AimRotationBits"),
+	10,
+	TEXT("Bits per axis used to replicate the aim of characters to simulated proxies (4-16)."));
+
+namespace QuantizedAimRotation
+{
+	static uint32 Quantize(float Angle, int32 NumBits)
+	{
+		const uint32 NumSteps = 1u << NumBits;
+		return FMath::RoundToInt(FRotator::ClampAxis(Angle) * NumSteps / 360.f) & (NumSteps - 1);
+	}
+
+	static float Dequantize(uint32 Value, int32 NumBits)
+	{
+		return FRotator::NormalizeAxis(Value * 360.f / (1u << NumBits));
+	}
+}
+
+bool FQuantizedAimRotation::DiffersFrom(const FQuantizedAimRotation& Other, float ToleranceDegrees) const
+{
+	return FMath::Abs(FRotator::NormalizeAxis(Pitch - Other.Pitch)) > ToleranceDegrees
+		|| FMath::Abs(FRotator::NormalizeAxis(Yaw - Other.Yaw)) > ToleranceDegrees;
+}
+
+bool FQuantizedAimRotation::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// 4 bits of header hold the bit depth minus one
+	uint32 NumBitsMinusOne = 0;
+	if (Ar.IsSaving())
+	{
+		NumBitsMinusOne = FMath::Clamp(CVarAimRotationBits.GetValueOnAnyThread(), 4, 16) - 1;
+	}
+	Ar.SerializeBits(&NumBitsMinusOne, 4);
+	const int32 NumBits = NumBitsMinusOne + 1;
+
+	uint32 QuantizedPitch = 0;
+	uint32 QuantizedYaw = 0;
+	if (Ar.IsSaving())
+	{
+		QuantizedPitch = QuantizedAimRotation::Quantize(Pitch, NumBits);
+		QuantizedYaw = QuantizedAimRotation::Quantize(Yaw, NumBits);
+	}
+	Ar.SerializeBits(&QuantizedPitch, NumBits);
+	Ar.SerializeBits(&QuantizedYaw, NumBits);
+	if (Ar.IsLoading())
+	{
+		Pitch = QuantizedAimRotation::Dequantize(QuantizedPitch, NumBits);
+		Yaw = QuantizedAimRotation::Dequantize(QuantizedYaw, NumBits);
+	}
+
+	bOutSuccess = true;
+	return true;
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "BonedShooter.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/SphereComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "GameplayCore/BonedShooterCharacter.h"
+#include "Weapon/Bullet.h"
+#include "Weapon/DamageQueueSubsystem.h"
+
+// The character the game spawns, the native class has no mesh
+static const TCHAR* HitZoneTestCharacterClass = TEXT("/Game/BonedShooter/Characters/Player/BP_BonedShooterCharacter.BP_BonedShooterCharacter_C");
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBonedShooterHeadHitZoneTest, "BonedShooter.Weapon.HitZones.HeadHit",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FBonedShooterHeadHitZoneTest::RunTest(const FString& Parameters)
+{
+	UClass* CharacterClass = LoadClass<ABonedShooterCharacter>(nullptr, HitZoneTestCharacterClass);
+	if (!TestNotNull(TEXT("Character class"), CharacterClass))
+	{
+		return false;
+	}
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("HitZoneTest"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->GetWorldSettings()->NotifyBeginPlay();
+	World->BeginPlay();
+
+	const ABonedShooterCharacter* Character = World->SpawnActor<ABonedShooterCharacter>(CharacterClass, FTransform::Identity);
+	const USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+	if (TestNotNull(TEXT("Character mesh"), Mesh))
+	{
+		// A bullet flying through the head from the front, as UBallisticMovementComponent sweeps it
+		const FVector Head = Mesh->GetSocketLocation(TEXT("head"));
+		const FVector Forward = Character->GetActorForwardVector();
+		const USphereComponent* BulletCollision = GetDefault<ABullet>()->CollisionComponent;
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HitZoneTest), false);
+		FCollisionResponseParams ResponseParams(BulletCollision->GetCollisionResponseToChannels());
+		FHitResult Hit;
+		const bool bHit = World->SweepSingleByChannel(Hit, Head + Forward * 200.f, Head - Forward * 200.f, FQuat::Identity, COLLISION_PROJECTILE,
+			BulletCollision->GetCollisionShape(), QueryParams, ResponseParams);
+
+		TestTrue(TEXT("Bullet sweep hits the character"), bHit);
+		TestTrue(TEXT("The mesh stops the bullet, not the capsule"), Hit.GetComponent() == Mesh);
+		TestEqual(TEXT("Hit bone"), Hit.BoneName.ToString(), FString(TEXT("head")));
+
+		UDamageQueueSubsystem* DamageQueue = World->GetSubsystem<UDamageQueueSubsystem>();
+		if (TestNotNull(TEXT("Damage queue"), DamageQueue))
+		{
+			TestEqual(TEXT("Head hit multiplier"), DamageQueue->GetHitZoneMultiplier(Hit), 4.f);
+		}
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
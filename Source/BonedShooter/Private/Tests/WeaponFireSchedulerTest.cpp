@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Weapon/WeaponFireScheduler.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBonedShooterWeaponFireSchedulerTest, "BonedShooter.Weapon.FireScheduler",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FBonedShooterWeaponFireSchedulerTest::RunTest(const FString& Parameters)
+{
+	const float StartTime = 10.f;
+	const float Interval = 0.1f;
+
+	// Frames at 144 Hz, 30 Hz and 60 Hz with a hitch of several intervals in the middle
+	const float FrameTimes[] = { 1.f / 144.f, 1.f / 30.f, 1.f / 144.f, 0.35f, 1.f / 60.f, 0.07f, 1.f / 144.f, 1.f / 30.f };
+
+	// --- Uncapped: every shot comes out, at its own time -- //
+	{
+		FWeaponFireScheduler Scheduler;
+		Scheduler.Start(StartTime, Interval, 0.f);
+
+		TArray<float, TInlineAllocator<16>> ShotTimes;
+		TArray<float> AllShotTimes;
+		const float EndTime = StartTime + 2.05f;
+		float Now = StartTime;
+		int32 Frame = 0;
+		while (true)
+		{
+			ShotTimes.Reset();
+			Scheduler.Advance(Now, MAX_int32, ShotTimes);
+			for (const float ShotTime : ShotTimes)
+			{
+				TestTrue(TEXT("Shot is not in the future"), ShotTime <= Now);
+				AllShotTimes.Add(ShotTime);
+			}
+
+			if (Now >= EndTime)
+			{
+				break;
+			}
+			Now = FMath::Min(Now + FrameTimes[Frame++ % UE_ARRAY_COUNT(FrameTimes)], EndTime);
+		}
+
+		// Shots at 10.0, 10.1, ... 12.0, whatever the frames were
+		TestEqual(TEXT("Shot count"), AllShotTimes.Num(), 21);
+		for (int32 Index = 0; Index < AllShotTimes.Num(); ++Index)
+		{
+			TestEqual(*FString::Printf(TEXT("Time of shot %d"), Index), AllShotTimes[Index], StartTime + Index * Interval, KINDA_SMALL_NUMBER);
+		}
+	}
+
+	// --- Capped: a hitch spills over the following frames without losing shots -- //
+	{
+		FWeaponFireScheduler Scheduler;
+		Scheduler.Start(StartTime, Interval, StartTime + 0.05f);
+
+		TArray<float, TInlineAllocator<16>> ShotTimes;
+		Scheduler.Advance(StartTime, 4, ShotTimes);
+		TestEqual(TEXT("No shot before the earliest first shot time"), ShotTimes.Num(), 0);
+
+		// 1 s hitch: 10 shots are due, 4 per frame
+		Scheduler.Advance(StartTime + 1.f, 4, ShotTimes);
+		TestEqual(TEXT("Shots of the hitch frame"), ShotTimes.Num(), 4);
+		Scheduler.Advance(StartTime + 1.01f, 4, ShotTimes);
+		Scheduler.Advance(StartTime + 1.02f, 4, ShotTimes);
+		TestEqual(TEXT("Shots after the spill over"), ShotTimes.Num(), 10);
+		for (int32 Index = 0; Index < ShotTimes.Num(); ++Index)
+		{
+			TestEqual(*FString::Printf(TEXT("Time of capped shot %d"), Index), ShotTimes[Index], StartTime + 0.05f + Index * Interval, KINDA_SMALL_NUMBER);
+		}
+
+		Scheduler.Stop();
+		ShotTimes.Reset();
+		Scheduler.Advance(StartTime + 5.f, 4, ShotTimes);
+		TestEqual(TEXT("No shot once stopped"), ShotTimes.Num(), 0);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
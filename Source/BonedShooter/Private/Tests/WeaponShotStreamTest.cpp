@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Math/RandomStream.h"
+#include "Weapon/WeaponShot.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBonedShooterWeaponShotStreamTest, "BonedShooter.Weapon.ShotResend",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FBonedShooterWeaponShotStreamTest::RunTest(const FString& Parameters)
+{
+	// Same bounds as AWeaponActor
+	const int32 MaxShotsPerBatch = 32;
+	const int32 MaxUnackedShots = 64;
+	const int32 NumShots = 200;
+
+	// A channel losing a third of the batches and of the acks, delivering the rest in any order
+	FRandomStream Random(0x5EED);
+	FWeaponShotSendQueue SendQueue;
+	FWeaponShotReceiveState ReceiveState;
+	TArray<FWeaponShotBatch> BatchesInFlight;
+	TArray<uint32> AcksInFlight;
+	TArray<int32> ProcessedShots;
+
+	int32 NumFired = 0;
+	for (int32 Frame = 0; Frame < 10000 && (NumFired < NumShots || !SendQueue.IsEmpty()); ++Frame)
+	{
+		// Client: one shot every other frame, then a flush, as QueueShot and FlushShots do
+		if (NumFired < NumShots && Frame % 2 == 0)
+		{
+			FWeaponShot Shot;
+			Shot.ShotIndex = (uint16)NumFired++;
+			SendQueue.Add(Shot, MaxUnackedShots);
+		}
+
+		FWeaponShotBatch Batch;
+		if (SendQueue.MakeBatch(MaxShotsPerBatch, Batch) && Random.FRand() > 0.33f)
+		{
+			BatchesInFlight.Insert(Batch, Random.RandRange(0, BatchesInFlight.Num()));
+		}
+
+		// Server: delivers some of the batches in flight, acks as ServerFireBatch does
+		while (BatchesInFlight.Num() > 0 && Random.FRand() < 0.6f)
+		{
+			const FWeaponShotBatch Received = BatchesInFlight.Pop(false);
+			for (int32 Index = 0; Index < Received.Shots.Num(); ++Index)
+			{
+				const uint32 Sequence = Received.FirstSequence + Index;
+				if (ReceiveState.Accept(Sequence))
+				{
+					TestEqual(TEXT("Shot carried by its sequence"), (int32)Received.Shots[Index].ShotIndex, (int32)Sequence - 1);
+					ProcessedShots.Add((int32)Sequence);
+				}
+			}
+
+			if (Random.FRand() > 0.33f)
+			{
+				AcksInFlight.Insert(ReceiveState.GetLastProcessedSequence(), Random.RandRange(0, AcksInFlight.Num()));
+			}
+		}
+
+		// Client: acknowledgements, late ones included
+		while (AcksInFlight.Num() > 0 && Random.FRand() < 0.6f)
+		{
+			SendQueue.Acknowledge(AcksInFlight.Pop(false));
+		}
+	}
+
+	// Never more than MaxUnackedShots waiting, so with that much loss nothing was given up and every shot made it once
+	TestTrue(TEXT("Every shot acknowledged"), SendQueue.IsEmpty());
+	TestEqual(TEXT("Processed shot count"), ProcessedShots.Num(), NumShots);
+	for (int32 Index = 0; Index < ProcessedShots.Num(); ++Index)
+	{
+		TestEqual(*FString::Printf(TEXT("Sequence of processed shot %d"), Index), ProcessedShots[Index], Index + 1);
+	}
+
+	// Late and repeated acks leave the queue alone
+	FWeaponShotSendQueue Queue;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		Queue.Add(FWeaponShot(), MaxUnackedShots);
+	}
+	Queue.Acknowledge(2);
+	Queue.Acknowledge(1);
+	Queue.Acknowledge(2);
+	TestEqual(TEXT("Shots left after late acks"), Queue.Num(), 2);
+
+	FWeaponShotBatch Batch;
+	Queue.MakeBatch(MaxShotsPerBatch, Batch);
+	TestEqual(TEXT("Resend starts at the oldest unacknowledged shot"), (int32)Batch.FirstSequence, 3);
+
+	// A full queue gives up its oldest shot, the sequences stay contiguous
+	FWeaponShotSendQueue FullQueue;
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		FullQueue.Add(FWeaponShot(), 2);
+	}
+	FullQueue.MakeBatch(MaxShotsPerBatch, Batch);
+	TestEqual(TEXT("Full queue keeps the newest shots"), Batch.Shots.Num(), 2);
+	TestEqual(TEXT("First sequence of the full queue"), (int32)Batch.FirstSequence, 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBonedShooterWeaponShotSeedTest, "BonedShooter.Weapon.ShotSeeds",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FBonedShooterWeaponShotSeedTest::RunTest(const FString& Parameters)
+{
+	// What an honest client sends: burst 1 of three shots, then burst 2
+	{
+		FWeaponShotSeedTracker Tracker;
+		TestTrue(TEXT("First shot of the first burst"), Tracker.Accept(1, 0, 0));
+		TestTrue(TEXT("Second shot"), Tracker.Accept(1, 1, 0));
+		TestTrue(TEXT("Third shot"), Tracker.Accept(1, 2, 0));
+		TestTrue(TEXT("Next burst"), Tracker.Accept(2, 0, 0));
+	}
+
+	// What a client searching for a good seed would send
+	{
+		FWeaponShotSeedTracker Tracker;
+		TestFalse(TEXT("Burst 0 never has a shot"), Tracker.Accept(0, 0, 0));
+		TestFalse(TEXT("Skipping bursts without skipped shots"), Tracker.Accept(5, 0, 0));
+		TestTrue(TEXT("First shot"), Tracker.Accept(1, 0, 0));
+		TestFalse(TEXT("Reused seed"), Tracker.Accept(1, 0, 0));
+		TestFalse(TEXT("Skipping indices without skipped shots"), Tracker.Accept(1, 3, 0));
+		TestFalse(TEXT("Older burst"), Tracker.Accept(0, 7, 0));
+		TestFalse(TEXT("New burst not starting at 0"), Tracker.Accept(2, 1, 0));
+		TestTrue(TEXT("Still the next shot"), Tracker.Accept(1, 1, 0));
+	}
+
+	// Shots the client gave up leave room for as many indices or bursts
+	{
+		FWeaponShotSeedTracker Tracker;
+		TestTrue(TEXT("First shot"), Tracker.Accept(1, 0, 0));
+		TestTrue(TEXT("Two shots of the burst skipped"), Tracker.Accept(1, 3, 2));
+		TestFalse(TEXT("More indices than skipped shots"), Tracker.Accept(1, 7, 2));
+		TestTrue(TEXT("Burst 2 and the first shot of burst 3 skipped"), Tracker.Accept(3, 1, 2));
+		TestFalse(TEXT("More bursts than skipped shots"), Tracker.Accept(6, 0, 1));
+	}
+
+	// The burst counter wraps around
+	{
+		FWeaponShotSeedTracker Tracker;
+		TestTrue(TEXT("Last burst before the wrap"), Tracker.Accept(MAX_uint16, 0, MAX_uint16));
+		TestTrue(TEXT("Burst after the wrap"), Tracker.Accept(0, 0, 0));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -3,14 +3,21 @@
 
 #include "Weapon/AimingComponent.h"
 
+#include "BonedShooter.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameplayCore/BonedShooterCharacter.h"
+
 // Sets default values for this component's properties
 UAimingComponent::UAimingComponent()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
+	// Ticks only while the owner aims, see SetAimingActive
 	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 
-	// ...
+	AimTraceDistance = 10000.f;
+	AimTraceChannel = ECC_Visibility;
 }
 
 
@@ -19,8 +26,14 @@ void UAimingComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ...
-	
+	// The animation reads the ticked solution from worker threads, make sure it is written before the mesh ticks
+	if (const ACharacter* Character = Cast<ACharacter>(GetOwner()))
+	{
+		if (USkeletalMeshComponent* Mesh = Character->GetMesh())
+		{
+			Mesh->PrimaryComponentTick.AddPrerequisite(this, PrimaryComponentTick);
+		}
+	}
 }
 
 
@@ -29,6 +42,51 @@ void UAimingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActo
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	// ...
+	TickedSolution = GetAimSolution();
+}
+
+void UAimingComponent::SetAimingActive(bool bActive)
+{
+	SetComponentTickEnabled(bActive);
+}
+
+const FAimSolution& UAimingComponent::GetAimSolution()
+{
+	if (SolutionFrame != GFrameCounter)
+	{
+		UpdateAimSolution();
+		SolutionFrame = GFrameCounter;
+	}
+	return Solution;
 }
 
+void UAimingComponent::UpdateAimSolution()
+{
+	AActor* Owner = GetOwner();
+	if (Owner == nullptr)
+	{
+		return;
+	}
+
+	// The weapon may arrive after the first trace, rebuild the ignore list when it does
+	ABonedShooterCharacter* Character = Cast<ABonedShooterCharacter>(Owner);
+	AActor* Weapon = Character ? Character->GetWeaponActor() : nullptr;
+	const bool bQueryParamsBuilt = QueryParams.GetIgnoredActors().Num() > 0;
+	if (!bQueryParamsBuilt || QueryParamsWeapon != Weapon)
+	{
+		QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(AimingComponentTrace), true, Owner);
+		QueryParams.AddIgnoredActor(Weapon);
+		QueryParamsWeapon = Weapon;
+	}
+
+	Owner->GetActorEyesViewPoint(Solution.ViewLocation, Solution.ViewRotation);
+	const FVector TraceEnd = Solution.ViewLocation + Solution.ViewRotation.Vector() * AimTraceDistance;
+
+	BONEDSHOOTER_COUNT(AimTraces, 1);
+	FHitResult Hit;
+	Solution.bHit = GetWorld()->LineTraceSingleByChannel(Hit, Solution.ViewLocation, TraceEnd, AimTraceChannel, QueryParams);
+	Solution.HitLocation = Solution.bHit ? Hit.Location : TraceEnd;
+	Solution.HitNormal = Solution.bHit ? FVector(Hit.ImpactNormal) : FVector::ZeroVector;
+	Solution.HitActor = Hit.GetActor();
+	Solution.HitDistance = Solution.bHit ? Hit.Distance : AimTraceDistance;
+}
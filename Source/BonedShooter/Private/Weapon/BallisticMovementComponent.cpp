@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/BallisticMovementComponent.h"
+
+#include "BonedShooter.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+void FBallisticTrajectory::Advance(FVector& Position, FVector& Velocity, const FVector& Gravity, float Drag, float DeltaTime)
+{
+	if (Drag <= KINDA_SMALL_NUMBER)
+	{
+		Position += (Velocity + 0.5f * Gravity * DeltaTime) * DeltaTime;
+		Velocity += Gravity * DeltaTime;
+		return;
+	}
+
+	// dv/dt = g - k v: the velocity decays exponentially towards the terminal velocity g / k
+	const FVector TerminalVelocity = Gravity / Drag;
+	const float Decay = FMath::Exp(-Drag * DeltaTime);
+	Position += TerminalVelocity * DeltaTime + (Velocity - TerminalVelocity) * ((1.f - Decay) / Drag);
+	Velocity = TerminalVelocity + (Velocity - TerminalVelocity) * Decay;
+}
+
+UBallisticMovementComponent::UBallisticMovementComponent()
+{
+	InitialSpeed = 30000.f;
+	GravityScale = 1.f;
+	Drag = 0.f;
+	MaxSegmentLength = 2000.f;
+	MaxSegmentsPerTick = 8;
+	bRotationFollowsVelocity = false;
+	SweepChannel = COLLISION_PROJECTILE;
+
+	// Like UProjectileMovementComponent, a Velocity left non-zero launches along it, in local space, on spawn
+	Velocity = FVector(1.f, 0.f, 0.f);
+	bWantsInitializeComponent = true;
+}
+
+void UBallisticMovementComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	if (UpdatedComponent && !Velocity.IsNearlyZero())
+	{
+		Launch(UpdatedComponent->GetComponentQuat().RotateVector(Velocity.GetSafeNormal()));
+	}
+}
+
+float UBallisticMovementComponent::GetGravityZ() const
+{
+	return Super::GetGravityZ() * GravityScale;
+}
+
+void UBallisticMovementComponent::Launch(const FVector& Direction)
+{
+	Velocity = Direction * InitialSpeed;
+	UpdateComponentVelocity();
+}
+
+void UBallisticMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	BONEDSHOOTER_SCOPE(BulletMovement);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (ShouldSkipUpdate(DeltaTime) || UpdatedComponent == nullptr || Velocity.IsZero() || DeltaTime <= 0.f)
+	{
+		return;
+	}
+
+	// Enough segments that none is longer than MaxSegmentLength, estimated from the speed at the start of the tick
+	const float TickDistance = Velocity.Size() * DeltaTime;
+	const int32 NumSegments = FMath::Clamp(FMath::CeilToInt(TickDistance / MaxSegmentLength), 1, FMath::Max(MaxSegmentsPerTick, 1));
+	const float SegmentTime = DeltaTime / NumSegments;
+	const FVector Gravity(0.f, 0.f, GetGravityZ());
+
+	FVector Position = UpdatedComponent->GetComponentLocation();
+	for (int32 Segment = 0; Segment < NumSegments; ++Segment)
+	{
+		const FVector SegmentStart = Position;
+		FBallisticTrajectory::Advance(Position, Velocity, Gravity, Drag, SegmentTime);
+
+		FHitResult Hit;
+		if (SweepSegment(SegmentStart, Position, Hit))
+		{
+			UpdatedComponent->SetWorldLocation(Hit.Location, false, nullptr, ETeleportType::TeleportPhysics);
+			UpdateComponentVelocity();
+
+			// Same notification a blocking swept move sends, OnComponentHit and ReceiveHit keep working
+			if (UpdatedPrimitive && GetOwner())
+			{
+				UpdatedPrimitive->DispatchBlockingHit(*GetOwner(), Hit);
+			}
+
+			// Handlers read the velocity of the impact, only stop afterwards
+			if (!IsPendingKill())
+			{
+				StopMovementImmediately();
+			}
+			return;
+		}
+	}
+
+	if (bRotationFollowsVelocity)
+	{
+		UpdatedComponent->SetWorldLocationAndRotation(Position, Velocity.ToOrientationQuat(), false, nullptr, ETeleportType::TeleportPhysics);
+	}
+	else
+	{
+		UpdatedComponent->SetWorldLocation(Position, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+	UpdateComponentVelocity();
+}
+
+bool UBallisticMovementComponent::SweepSegment(const FVector& Start, const FVector& End, FHitResult& OutHit) const
+{
+	const UPrimitiveComponent* Primitive = UpdatedPrimitive;
+	if (Primitive == nullptr || !Primitive->IsQueryCollisionEnabled())
+	{
+		return false;
+	}
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(BallisticMovementSweep), false, GetOwner());
+	QueryParams.bReturnPhysicalMaterial = Primitive->bReturnMaterialOnMove;
+	QueryParams.IgnoreMask = Primitive->GetMoveIgnoreMask();
+	if (const AActor* Owner = GetOwner())
+	{
+		QueryParams.AddIgnoredActor(Owner->GetOwner());
+		QueryParams.AddIgnoredActor(Owner->GetInstigator());
+	}
+
+	FCollisionResponseParams ResponseParams;
+	Primitive->InitSweepCollisionParams(QueryParams, ResponseParams);
+
+	BONEDSHOOTER_COUNT(BulletSweeps, 1);
+
+	return GetWorld()->SweepSingleByChannel(OutHit, Start, End, Primitive->GetComponentQuat(), SweepChannel,
+		Primitive->GetCollisionShape(), QueryParams, ResponseParams);
+}
@@ -2,9 +2,15 @@
 
 
 #include "Weapon/Bullet.h"
+#include "BonedShooter.h"
 #include "Components/SphereComponent.h"
-#include "GameFramework/ProjectileMovementComponent.h"
-#include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Weapon/BallisticMovementComponent.h"
+#include "Weapon/DamageQueueSubsystem.h"
+#include "Weapon/ProjectilePoolSubsystem.h"
+#include "Weapon/ShotTelemetrySubsystem.h"
+#include "Weapon/WeaponActor.h"
 
 // Sets default values
 ABullet::ABullet()
@@ -26,37 +32,43 @@ ABullet::ABullet()
 	ProjectileMeshComponent->SetupAttachment(RootComponent);
 
 	// Projectile Setup.
-	ProjectileMovementComponent = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("ProjectileMovementComponent"));
-	ProjectileMovementComponent->SetUpdatedComponent(CollisionComponent);
-	ProjectileMovementComponent->InitialSpeed = 1000.0f;
-	ProjectileMovementComponent->MaxSpeed = 1000.0f;
-	ProjectileMovementComponent->bRotationFollowsVelocity = false;
-	ProjectileMovementComponent->bShouldBounce = false;
-	ProjectileMovementComponent->ProjectileGravityScale = 0.0f;
+	BallisticMovementComponent = CreateDefaultSubobject<UBallisticMovementComponent>(TEXT("BallisticMovementComponent"));
+	BallisticMovementComponent->SetUpdatedComponent(CollisionComponent);
+	BallisticMovementComponent->InitialSpeed = 30000.0f;
+	BallisticMovementComponent->GravityScale = 1.0f;
+	BallisticMovementComponent->Drag = 0.1f;
+	BallisticMovementComponent->bRotationFollowsVelocity = true;
 
 
 	// Lifecycle
 	InitialLifeSpan = 2.0f;
 
 	//Collisions
-	CollisionComponent->BodyInstance.SetObjectType(ECC_WorldDynamic);
-	CollisionComponent->BodyInstance.SetResponseToAllChannels(ECR_Block);
-	CollisionComponent->BodyInstance.SetResponseToChannel(ECC_Camera, ECR_Ignore);
-	CollisionComponent->BodyInstance.SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-	CollisionComponent->BodyInstance.bNotifyRigidBodyCollision = true;
+	// Query only: the ballistic mover sweeps the sphere itself, the physics scene never simulates it
+	CollisionComponent->SetCollisionProfileName(TEXT("Bullet"));
+	CollisionComponent->SetGenerateOverlapEvents(false);
+	CollisionComponent->CanCharacterStepUpOn = ECB_No;
+	// Hit zones read the surface type of what was hit
+	CollisionComponent->bReturnMaterialOnMove = true;
+	CollisionComponent->SetMoveIgnoreMask(BulletMaskFilter);
 
 	CollisionComponent->OnComponentHit.AddDynamic(this, &ABullet::OnHit);
 
 	// Replication specs
+	// Movement is simulated on clients from the launch, after that a bullet barely changes: replicate it at a low rate,
+	// and only to viewers close enough to see it. The replication graph turns the rate into a period in server frames.
 	bReplicates = true;
-	MinNetUpdateFrequency = 33.f;
+	NetUpdateFrequency = 33.f;
+	MinNetUpdateFrequency = 2.f;
+	NetCullDistanceSquared = FMath::Square(5000.f);
 }
 
 // Called when the game starts or when spawned
 void ABullet::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	CollisionComponent->SetMaskFilterOnBodyInstance(BulletMaskFilter);
 }
 
 // Called every frame
@@ -68,21 +80,166 @@ void ABullet::Tick(float DeltaTime)
 
 void ABullet::LaunchInDirection(const FVector& ShootDirection)
 {
-	ProjectileMovementComponent->Velocity = ShootDirection * ProjectileMovementComponent->InitialSpeed;
+	BallisticMovementComponent->Launch(ShootDirection);
+
+	if (HasAuthority() && GetIsReplicated())
+	{
+		// Parked bullets sleep, see OnReturnedToPool
+		SetNetDormancy(DORM_Awake);
+
+		LaunchState.Origin = GetActorLocation();
+		LaunchState.Direction = ShootDirection;
+		++LaunchState.LaunchCount;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ABullet, LaunchState, this);
+	}
+}
+
+void ABullet::OnRep_LaunchState()
+{
+	// A reused bullet wakes up on the client copy it had before parking, nothing else tells it that it flies again
+	BeginFlight(FTransform(LaunchState.Direction.Rotation(), LaunchState.Origin));
+	BallisticMovementComponent->Launch(LaunchState.Direction);
 }
 
 void ABullet::OnHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComponent,
 	FVector NormalImpulse, const FHitResult& Hit)
 {
-	if (OtherActor != this)
+	BONEDSHOOTER_SCOPE(BulletHit);
+
+	// Client copies of replicated bullets stop where they hit, the server deals the damage
+	if (OtherActor != this && !bCosmeticOnly && HasAuthority())
+	{
+		// Pooled bullets are owned by the weapon that fired them, the instigator may be gone by the time they land
+		QueueHitDamage(Hit, GetVelocity().GetSafeNormal(), Cast<AWeaponActor>(GetOwner()), GetInstigator(), this, ShotSequence);
+	}
+	FinishFlight();
+}
+
+void ABullet::QueueHitDamage(const FHitResult& Hit, const FVector& ShotDirection, const AWeaponActor* Weapon, APawn* DamageInstigator, AActor* DamageCauser, uint32 ShotSequence)
+{
+	// Damage comes from the weapon, a bullet outliving it has nothing left to deal
+	if (Weapon == nullptr)
+	{
+		return;
+	}
+
+	// Only the server deals damage and knows the sequence of the shot
+	UWorld* World = Weapon->GetWorld();
+	if (World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+	if (UDamageQueueSubsystem* DamageQueue = World->GetSubsystem<UDamageQueueSubsystem>())
+	{
+		DamageQueue->QueueHit(Hit, ShotDirection, Weapon, DamageInstigator, DamageCauser);
+	}
+
+	if (UShotTelemetrySubsystem* Telemetry = World->GetSubsystem<UShotTelemetrySubsystem>())
+	{
+		FShotTelemetryRecord Record;
+		Record.Kind = EShotTelemetryKind::Hit;
+		Record.Flags = ShotTelemetryFlags::Blocked | (Cast<APawn>(Hit.GetActor()) ? ShotTelemetryFlags::Pawn : 0);
+		Record.ShooterId = Weapon->GetShooterId();
+		Record.WeaponSeed = Weapon->GetSpreadSeed();
+		Record.Sequence = ShotSequence;
+		Record.RecordTime = World->GetTimeSeconds();
+		Record.Direction = ShotDirection;
+		Record.Location = Hit.ImpactPoint;
+		Telemetry->Record(Record);
+	}
+}
+
+void ABullet::SetCosmeticOnly(bool bInCosmeticOnly)
+{
+	if (bCosmeticOnly != bInCosmeticOnly)
 	{
-		// Optional parameters, for visual clarity
-		float BaseDamage = 1.f;
-		
-		UGameplayStatics::ApplyPointDamage(OtherActor, BaseDamage, GetVelocity().GetSafeNormal(),
-			Hit, GetInstigator()->GetInstigatorController(), this, UDamageType::StaticClass());
-		
+		bCosmeticOnly = bInCosmeticOnly;
+		SetReplicates(!bCosmeticOnly);
+	}
+}
+
+void ABullet::OnAcquiredFromPool(const FTransform& SpawnTransform, AActor* NewOwner, APawn* NewInstigator)
+{
+	SetOwner(NewOwner);
+	SetInstigator(NewInstigator);
+	BeginFlight(SpawnTransform);
+
+	// The update rate may have dropped during the previous flight, the new one must go out now
+	ForceNetUpdate();
+}
+
+void ABullet::BeginFlight(const FTransform& SpawnTransform)
+{
+	bInPool = false;
+	SetActorLocationAndRotation(SpawnTransform.GetLocation(), SpawnTransform.GetRotation(), false, nullptr, ETeleportType::TeleportPhysics);
+
+	BallisticMovementComponent->Velocity = FVector::ZeroVector;
+	BallisticMovementComponent->SetComponentTickEnabled(true);
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// InitialLifeSpan doubles as the flight time of every reuse
+	SetLifeSpan(InitialLifeSpan);
+}
+
+void ABullet::OnReturnedToPool()
+{
+	bInPool = true;
+	SetLifeSpan(0.f);
+
+	BallisticMovementComponent->StopMovementImmediately();
+	BallisticMovementComponent->SetComponentTickEnabled(false);
+
+	// The replication graph doesn't drop hidden actors the way IsNetRelevantFor does, parked bullets would stay in its
+	// grid with their channels open. They go dormant instead: channels close, client copies stay parked until
+	// LaunchInDirection wakes them up and OnRep_LaunchState re-launches them.
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+	if (HasAuthority() && GetIsReplicated())
+	{
+		SetNetDormancy(DORM_DormantAll);
+	}
+
+	// Owner and instigator replicate, and the next launch of a bullet is often by the same shooter: the server doesn't
+	// send them again then, a client copy has to keep them to go on ignoring the shooter in its sweeps
+	if (HasAuthority())
+	{
+		SetOwner(nullptr);
+		SetInstigator(nullptr);
+	}
+}
+
+void ABullet::FinishFlight()
+{
+	if (!HasAuthority())
+	{
+		// The server owns the lifetime of replicated bullets, the client copy waits hidden for the next launch
+		OnReturnedToPool();
+		return;
+	}
+
+	if (bIsPooled)
+	{
+		if (UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+		{
+			Pool->ReleaseBullet(this);
+			return;
+		}
 	}
 	Destroy();
 }
 
+void ABullet::LifeSpanExpired()
+{
+	FinishFlight();
+}
+
+void ABullet::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ABullet, LaunchState, Params);
+}
@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/DamageQueueSubsystem.h"
+
+#include "BonedShooter.h"
+#include "Animation/Skeleton.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Kismet/GameplayStatics.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Weapon/WeaponActor.h"
+
+bool UDamageQueueSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && (World->WorldType == EWorldType::Game || World->WorldType == EWorldType::PIE);
+}
+
+void UDamageQueueSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// Surface types are a fixed enum, the whole table fits in one array
+	for (float& Multiplier : SurfaceMultipliers)
+	{
+		Multiplier = 1.f;
+	}
+	for (const FSurfaceHitZone& Zone : SurfaceHitZones)
+	{
+		SurfaceMultipliers[Zone.SurfaceType] = Zone.DamageMultiplier;
+	}
+
+	// Runs once every actor, component and tickable object has ticked, so all the hits of the frame are in
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UDamageQueueSubsystem::OnWorldPostActorTick);
+}
+
+void UDamageQueueSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	QueuedHits.Empty();
+	ResolvingHits.Empty();
+	BoneMultipliersBySkeleton.Empty();
+
+	Super::Deinitialize();
+}
+
+void UDamageQueueSubsystem::QueueHit(const FHitResult& Hit, const FVector& ShotDirection, const AWeaponActor* Weapon, APawn* DamageInstigator, AActor* DamageCauser)
+{
+	AActor* Victim = Hit.GetActor();
+	if (Victim == nullptr || Weapon == nullptr)
+	{
+		return;
+	}
+
+	BONEDSHOOTER_COUNT(Hits, 1);
+
+	FQueuedHit& QueuedHit = QueuedHits.AddDefaulted_GetRef();
+	QueuedHit.Victim = Victim;
+	QueuedHit.Hit = Hit;
+	QueuedHit.ShotDirection = ShotDirection;
+	QueuedHit.BaseDamage = Weapon->GetDefaultDamage();
+	QueuedHit.DamageTypeClass = Weapon->GetDamageTypeClass();
+	QueuedHit.InstigatorController = DamageInstigator ? DamageInstigator->GetController() : nullptr;
+	QueuedHit.DamageCauser = DamageCauser;
+}
+
+void UDamageQueueSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld() && QueuedHits.Num() > 0)
+	{
+		ResolveQueuedHits();
+	}
+}
+
+void UDamageQueueSubsystem::ResolveQueuedHits()
+{
+	BONEDSHOOTER_SCOPE(ResolveDamage);
+
+	check(ResolvingHits.Num() == 0);
+	Swap(QueuedHits, ResolvingHits);
+
+	for (FQueuedHit& QueuedHit : ResolvingHits)
+	{
+		// Another hit of the batch may have destroyed the victim already
+		AActor* Victim = QueuedHit.Victim.Get();
+		if (Victim == nullptr || Victim->IsPendingKillPending())
+		{
+			continue;
+		}
+
+		const float Damage = QueuedHit.BaseDamage * GetHitZoneMultiplier(QueuedHit.Hit);
+		UGameplayStatics::ApplyPointDamage(Victim, Damage, QueuedHit.ShotDirection, QueuedHit.Hit,
+			QueuedHit.InstigatorController.Get(), QueuedHit.DamageCauser.Get(),
+			QueuedHit.DamageTypeClass ? *QueuedHit.DamageTypeClass : UDamageType::StaticClass());
+	}
+
+	ResolvingHits.Reset();
+}
+
+float UDamageQueueSubsystem::GetHitZoneMultiplier(const FHitResult& Hit)
+{
+	float Multiplier = 1.f;
+
+	if (const UPhysicalMaterial* PhysMaterial = Hit.PhysMaterial.Get())
+	{
+		Multiplier *= SurfaceMultipliers[PhysMaterial->SurfaceType];
+	}
+
+	if (Hit.BoneName != NAME_None)
+	{
+		const USkeletalMeshComponent* Mesh = Cast<USkeletalMeshComponent>(Hit.GetComponent());
+		const USkeleton* Skeleton = Mesh && Mesh->SkeletalMesh ? Mesh->SkeletalMesh->Skeleton : nullptr;
+		if (Skeleton)
+		{
+			// FName lookup through the skeleton's name map, then a plain array read
+			const int32 BoneIndex = Skeleton->GetReferenceSkeleton().FindBoneIndex(Hit.BoneName);
+			const TArray<float>& BoneMultipliers = GetBoneMultipliers(Skeleton);
+			if (BoneMultipliers.IsValidIndex(BoneIndex))
+			{
+				Multiplier *= BoneMultipliers[BoneIndex];
+			}
+		}
+	}
+
+	return Multiplier;
+}
+
+const TArray<float>& UDamageQueueSubsystem::GetBoneMultipliers(const USkeleton* Skeleton)
+{
+	if (const TArray<float>* Existing = BoneMultipliersBySkeleton.Find(Skeleton))
+	{
+		return *Existing;
+	}
+
+	const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+	const int32 NumBones = RefSkeleton.GetNum();
+
+	TArray<float>& BoneMultipliers = BoneMultipliersBySkeleton.Add(Skeleton);
+	BoneMultipliers.Init(1.f, NumBones);
+
+	TBitArray<> HasOwnZone(false, NumBones);
+	for (const FBoneHitZone& Zone : BoneHitZones)
+	{
+		const int32 BoneIndex = RefSkeleton.FindBoneIndex(Zone.BoneName);
+		if (BoneIndex != INDEX_NONE)
+		{
+			BoneMultipliers[BoneIndex] = Zone.DamageMultiplier;
+			HasOwnZone[BoneIndex] = true;
+		}
+	}
+
+	// Parents come before their children in the reference skeleton, one pass spreads the zones down the hierarchy
+	for (int32 BoneIndex = 1; BoneIndex < NumBones; ++BoneIndex)
+	{
+		if (!HasOwnZone[BoneIndex])
+		{
+			BoneMultipliers[BoneIndex] = BoneMultipliers[RefSkeleton.GetParentIndex(BoneIndex)];
+		}
+	}
+
+	return BoneMultipliers;
+}
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/FireValidationSubsystem.h"
+
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+bool UFireValidationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && (World->WorldType == EWorldType::Game || World->WorldType == EWorldType::PIE);
+}
+
+void UFireValidationSubsystem::Deinitialize()
+{
+	StatsByConnection.Empty();
+
+	Super::Deinitialize();
+}
+
+void UFireValidationSubsystem::RecordShot(UNetConnection* Connection, EShotRejection Rejection)
+{
+	if (Connection == nullptr)
+	{
+		return;
+	}
+
+	FFireRejectionStats& Stats = StatsByConnection.FindOrAdd(Connection);
+	switch (Rejection)
+	{
+	case EShotRejection::None:
+		++Stats.ShotsAccepted;
+		break;
+	case EShotRejection::RateLimited:
+		++Stats.ShotsRateLimited;
+		break;
+	case EShotRejection::ImplausibleOrigin:
+		++Stats.ShotsImplausibleOrigin;
+		break;
+	case EShotRejection::InvalidSeed:
+		++Stats.ShotsInvalidSeed;
+		break;
+	}
+}
+
+FFireRejectionStats UFireValidationSubsystem::GetStats(UNetConnection* Connection) const
+{
+	const FFireRejectionStats* Stats = StatsByConnection.Find(Connection);
+	return Stats ? *Stats : FFireRejectionStats();
+}
+
+void UFireValidationSubsystem::DumpStats()
+{
+	for (auto It = StatsByConnection.CreateIterator(); It; ++It)
+	{
+		// Closed connections are only forgotten here, nothing on the firing path pays for it
+		const UNetConnection* Connection = It.Key().Get();
+		if (Connection == nullptr)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		const FFireRejectionStats& Stats = It.Value();
+		UE_LOG(LogTemp, Log, TEXT("Fire validation: %s accepted %d, rate limited %d, implausible origin %d, invalid seed %d"),
+			*Connection->LowLevelGetRemoteAddress(), Stats.ShotsAccepted, Stats.ShotsRateLimited, Stats.ShotsImplausibleOrigin, Stats.ShotsInvalidSeed);
+	}
+}
+
+static FAutoConsoleCommandWithWorld GDumpFireRejectionsCommand(
+	TEXT("BonedShooter.DumpFireRejections"),
+	TEXT("Server: logs, for every client connection, how many shots were accepted and why the others were rejected."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UFireValidationSubsystem* FireValidation = World ? World->GetSubsystem<UFireValidationSubsystem>() : nullptr)
+		{
+			FireValidation->DumpStats();
+		}
+	}));
@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/ProjectilePoolSubsystem.h"
+
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Weapon/Bullet.h"
+
+bool UProjectilePoolSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	// Only game worlds fire bullets, editor preview worlds don't need a pool
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && (World->WorldType == EWorldType::Game || World->WorldType == EWorldType::PIE);
+}
+
+void UProjectilePoolSubsystem::Deinitialize()
+{
+	// Bullets belong to the level and go away with it, just drop our references
+	Buckets.Empty();
+
+	Super::Deinitialize();
+}
+
+void UProjectilePoolSubsystem::Prewarm(TSubclassOf<ABullet> ProjectileClass, int32 Count)
+{
+	if (ProjectileClass == nullptr)
+	{
+		return;
+	}
+
+	FProjectilePoolBucket& Bucket = Buckets.FindOrAdd(ProjectileClass);
+	const int32 Target = FMath::Min(Count, MaxFreePerClass);
+	while (Bucket.FreeBullets.Num() < Target)
+	{
+		ABullet* Bullet = SpawnPooledBullet(ProjectileClass);
+		if (Bullet == nullptr)
+		{
+			break;
+		}
+		Bucket.FreeBullets.Add(Bullet);
+	}
+	Bucket.Stats.NumFree = Bucket.FreeBullets.Num();
+}
+
+ABullet* UProjectilePoolSubsystem::AcquireBullet(TSubclassOf<ABullet> ProjectileClass, const FTransform& SpawnTransform, AActor* BulletOwner, APawn* BulletInstigator)
+{
+	if (ProjectileClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	FProjectilePoolBucket& Bucket = Buckets.FindOrAdd(ProjectileClass);
+
+	// Pop until we find a bullet that survived since it was parked (level streaming, manual destroy...)
+	ABullet* Bullet = nullptr;
+	while (Bullet == nullptr && Bucket.FreeBullets.Num() > 0)
+	{
+		ABullet* Candidate = Bucket.FreeBullets.Pop(false);
+		if (IsValid(Candidate))
+		{
+			Bullet = Candidate;
+		}
+	}
+
+	if (Bullet)
+	{
+		++Bucket.Stats.PoolHits;
+	}
+	else
+	{
+		++Bucket.Stats.PoolMisses;
+
+		// Grow by a batch so a sustained burst doesn't miss on every shot
+		for (int32 Index = 1; Index < GrowBatchSize && Bucket.FreeBullets.Num() < MaxFreePerClass; ++Index)
+		{
+			if (ABullet* Extra = SpawnPooledBullet(ProjectileClass))
+			{
+				Bucket.FreeBullets.Add(Extra);
+			}
+		}
+		Bullet = SpawnPooledBullet(ProjectileClass);
+		if (Bullet == nullptr)
+		{
+			return nullptr;
+		}
+	}
+
+	Bullet->OnAcquiredFromPool(SpawnTransform, BulletOwner, BulletInstigator);
+
+	++Bucket.Stats.NumActive;
+	Bucket.Stats.NumFree = Bucket.FreeBullets.Num();
+	Bucket.Stats.PeakActive = FMath::Max(Bucket.Stats.PeakActive, Bucket.Stats.NumActive);
+	Bucket.WindowPeakActive = FMath::Max(Bucket.WindowPeakActive, Bucket.Stats.NumActive);
+
+	return Bullet;
+}
+
+void UProjectilePoolSubsystem::ReleaseBullet(ABullet* Bullet)
+{
+	// A hit and the life span can both end the same flight, only the first one counts
+	if (!IsValid(Bullet) || Bullet->IsInPool())
+	{
+		return;
+	}
+
+	FProjectilePoolBucket* Bucket = Buckets.Find(Bullet->GetClass());
+	if (Bucket == nullptr || Bucket->FreeBullets.Num() >= MaxFreePerClass)
+	{
+		Bullet->Destroy();
+		if (Bucket)
+		{
+			Bucket->Stats.NumActive = FMath::Max(Bucket->Stats.NumActive - 1, 0);
+		}
+		return;
+	}
+
+	Bullet->OnReturnedToPool();
+	Bucket->FreeBullets.Add(Bullet);
+
+	Bucket->Stats.NumActive = FMath::Max(Bucket->Stats.NumActive - 1, 0);
+	Bucket->Stats.NumFree = Bucket->FreeBullets.Num();
+
+	TrimBucket(*Bucket);
+}
+
+FProjectilePoolStats UProjectilePoolSubsystem::GetPoolStats(TSubclassOf<ABullet> ProjectileClass) const
+{
+	const FProjectilePoolBucket* Bucket = Buckets.Find(ProjectileClass);
+	return Bucket ? Bucket->Stats : FProjectilePoolStats();
+}
+
+int32 UProjectilePoolSubsystem::GetNumActive() const
+{
+	int32 NumActive = 0;
+	for (const TPair<UClass*, FProjectilePoolBucket>& Pair : Buckets)
+	{
+		NumActive += Pair.Value.Stats.NumActive;
+	}
+	return NumActive;
+}
+
+void UProjectilePoolSubsystem::DumpStats() const
+{
+	for (const TPair<UClass*, FProjectilePoolBucket>& Pair : Buckets)
+	{
+		const FProjectilePoolStats& Stats = Pair.Value.Stats;
+		UE_LOG(LogTemp, Log, TEXT("ProjectilePool %s: Hits=%d Misses=%d Active=%d Free=%d PeakActive=%d"),
+			*GetNameSafe(Pair.Key), Stats.PoolHits, Stats.PoolMisses, Stats.NumActive, Stats.NumFree, Stats.PeakActive);
+	}
+}
+
+ABullet* UProjectilePoolSubsystem::SpawnPooledBullet(UClass* ProjectileClass)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ABullet* Bullet = GetWorld()->SpawnActor<ABullet>(ProjectileClass, FTransform::Identity, SpawnParams);
+	if (Bullet)
+	{
+		Bullet->bIsPooled = true;
+		Bullet->OnReturnedToPool();
+	}
+	return Bullet;
+}
+
+void UProjectilePoolSubsystem::TrimBucket(FProjectilePoolBucket& Bucket)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (Now - Bucket.LastTrimTime < TrimInterval)
+	{
+		return;
+	}
+	Bucket.LastTrimTime = Now;
+
+	// Keep enough bullets to cover the recent peak on top of what is in flight right now
+	const int32 KeepFree = FMath::Clamp(FMath::Max(MinFreePerClass, Bucket.WindowPeakActive - Bucket.Stats.NumActive), 0, MaxFreePerClass);
+	int32 NumToTrim = FMath::Min(Bucket.FreeBullets.Num() - KeepFree, MaxTrimPerPass);
+	while (NumToTrim-- > 0)
+	{
+		ABullet* Bullet = Bucket.FreeBullets.Pop(false);
+		if (IsValid(Bullet))
+		{
+			Bullet->Destroy();
+		}
+	}
+
+	Bucket.WindowPeakActive = Bucket.Stats.NumActive;
+	Bucket.Stats.NumFree = Bucket.FreeBullets.Num();
+}
+
+static FAutoConsoleCommandWithWorld GDumpProjectilePoolCommand(
+	TEXT("BonedShooter.DumpProjectilePool"),
+	TEXT("Logs hit/miss/occupancy counters of the projectile pool."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UProjectilePoolSubsystem* Pool = World ? World->GetSubsystem<UProjectilePoolSubsystem>() : nullptr)
+		{
+			Pool->DumpStats();
+		}
+	}));
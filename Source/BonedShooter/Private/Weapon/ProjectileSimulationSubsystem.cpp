@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/ProjectileSimulationSubsystem.h"
+
+#include "BonedShooter.h"
+#include "Async/ParallelFor.h"
+#include "CollisionQueryParams.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Weapon/BallisticMovementComponent.h"
+#include "Weapon/Bullet.h"
+#include "Weapon/WeaponActor.h"
+
+bool UProjectileSimulationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && (World->WorldType == EWorldType::Game || World->WorldType == EWorldType::PIE);
+}
+
+void UProjectileSimulationSubsystem::Deinitialize()
+{
+	Positions.Empty();
+	Velocities.Empty();
+	GravityZs.Empty();
+	Drags.Empty();
+	RemainingLife.Empty();
+	Owners.Empty();
+	Instigators.Empty();
+	ShotSequences.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UProjectileSimulationSubsystem::IsTickable() const
+{
+	return !IsTemplate() && Positions.Num() > 0;
+}
+
+TStatId UProjectileSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSimulationSubsystem, STATGROUP_BonedShooter);
+}
+
+void UProjectileSimulationSubsystem::SpawnProjectile(const FVector& Origin, const FVector& Velocity, float GravityZ, float Drag, float LifeSpan, AActor* ProjectileOwner, APawn* ProjectileInstigator, uint32 ShotSequence)
+{
+	Positions.Add(Origin);
+	Velocities.Add(Velocity);
+	GravityZs.Add(GravityZ);
+	Drags.Add(Drag);
+	RemainingLife.Add(LifeSpan);
+	Owners.Add(ProjectileOwner);
+	Instigators.Add(ProjectileInstigator);
+	ShotSequences.Add(ShotSequence);
+}
+
+void UProjectileSimulationSubsystem::Tick(float DeltaTime)
+{
+	UWorld* World = GetWorld();
+	const int32 NumProjectiles = Positions.Num();
+	if (World == nullptr || NumProjectiles == 0)
+	{
+		return;
+	}
+
+	// Resolve weak pointers once on the game thread, workers only read raw pointers
+	ScratchIgnoredOwners.SetNumUninitialized(NumProjectiles, false);
+	ScratchIgnoredInstigators.SetNumUninitialized(NumProjectiles, false);
+	for (int32 Index = 0; Index < NumProjectiles; ++Index)
+	{
+		ScratchIgnoredOwners[Index] = Owners[Index].Get();
+		ScratchIgnoredInstigators[Index] = Instigators[Index].Get();
+	}
+
+	ScratchNextPositions.SetNumUninitialized(NumProjectiles, false);
+	ScratchNextVelocities.SetNumUninitialized(NumProjectiles, false);
+	ScratchHits.SetNum(NumProjectiles, false);
+	ScratchHitFlags.SetNumZeroed(NumProjectiles, false);
+
+	// Sweep every bullet along this frame's segment. Scene queries only read the physics scene, which is not
+	// simulating at this point of the frame, so the batch can be spread across worker threads.
+	BONEDSHOOTER_COUNT(BulletSweeps, NumProjectiles);
+	const FCollisionShape SweepShape = FCollisionShape::MakeSphere(SweepRadius);
+	const bool bForceSingleThread = NumProjectiles < MinProjectilesForParallelSweep;
+	ParallelFor(NumProjectiles, [this, World, DeltaTime, &SweepShape](int32 Index)
+	{
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectileSimulationSweep), false);
+		QueryParams.bReturnPhysicalMaterial = true;
+		QueryParams.IgnoreMask = ABullet::BulletMaskFilter;
+		QueryParams.AddIgnoredActor(ScratchIgnoredOwners[Index]);
+		QueryParams.AddIgnoredActor(ScratchIgnoredInstigators[Index]);
+
+		// One frame of the analytic trajectory, swept as a single chord
+		const FVector Start = Positions[Index];
+		FVector& End = ScratchNextPositions[Index];
+		End = Start;
+		ScratchNextVelocities[Index] = Velocities[Index];
+		FBallisticTrajectory::Advance(End, ScratchNextVelocities[Index], FVector(0.f, 0.f, GravityZs[Index]), Drags[Index], DeltaTime);
+
+		// Same channel as the actor bullets, capsules let it through and the bodies of the mesh stop it
+		ScratchHitFlags[Index] = World->SweepSingleByChannel(ScratchHits[Index], Start, End, FQuat::Identity, COLLISION_PROJECTILE, SweepShape, QueryParams) ? 1 : 0;
+	}, bForceSingleThread);
+
+	// Integrate and resolve hits in a single pass, walking backwards so removals don't disturb the remaining indices
+	for (int32 Index = NumProjectiles - 1; Index >= 0; --Index)
+	{
+		if (ScratchHitFlags[Index])
+		{
+			const FHitResult& Hit = ScratchHits[Index];
+			AActor* ProjectileOwner = Owners[Index].Get();
+			ABullet::QueueHitDamage(Hit, Velocities[Index].GetSafeNormal(), Cast<AWeaponActor>(ProjectileOwner),
+				Instigators[Index].Get(), ProjectileOwner, ShotSequences[Index]);
+
+			RemoveProjectileAtSwap(Index);
+			continue;
+		}
+
+		Positions[Index] = ScratchNextPositions[Index];
+		Velocities[Index] = ScratchNextVelocities[Index];
+		RemainingLife[Index] -= DeltaTime;
+		if (RemainingLife[Index] <= 0.f)
+		{
+			RemoveProjectileAtSwap(Index);
+		}
+	}
+}
+
+void UProjectileSimulationSubsystem::RemoveProjectileAtSwap(int32 Index)
+{
+	Positions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	GravityZs.RemoveAtSwap(Index, 1, false);
+	Drags.RemoveAtSwap(Index, 1, false);
+	RemainingLife.RemoveAtSwap(Index, 1, false);
+	Owners.RemoveAtSwap(Index, 1, false);
+	Instigators.RemoveAtSwap(Index, 1, false);
+	ShotSequences.RemoveAtSwap(Index, 1, false);
+}
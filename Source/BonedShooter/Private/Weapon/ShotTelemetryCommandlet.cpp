@@ -0,0 +1,295 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/ShotTelemetryCommandlet.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Paths.h"
+#include "Weapon/ShotTelemetrySubsystem.h"
+
+namespace ShotTelemetryAnalysis
+{
+	/** A log mapped in memory, its records are read in place */
+	struct FMappedLog
+	{
+		FString Path;
+		TUniquePtr<IMappedFileHandle> Handle;
+		TUniquePtr<IMappedFileRegion> Region;
+		const FShotTelemetryRecord* Records = nullptr;
+		int64 NumRecords = 0;
+		uint32 SessionId = 0;
+	};
+
+	/** Identifies a shot across the logs of a session, and apart from the shots of other sessions */
+	struct FShotKey
+	{
+		uint32 SessionId = 0;
+		int32 WeaponSeed = 0;
+		uint32 Sequence = 0;
+
+		bool operator==(const FShotKey& Other) const
+		{
+			return SessionId == Other.SessionId && WeaponSeed == Other.WeaponSeed && Sequence == Other.Sequence;
+		}
+
+		friend uint32 GetTypeHash(const FShotKey& Key)
+		{
+			return HashCombine(HashCombine(::GetTypeHash(Key.SessionId), ::GetTypeHash(Key.WeaponSeed)), ::GetTypeHash(Key.Sequence));
+		}
+	};
+
+	/** Everything both sides recorded about one shot */
+	struct FJoinedShot
+	{
+		const FShotTelemetryRecord* Fire = nullptr;
+		const FShotTelemetryRecord* Process = nullptr;
+		int32 NumHits = 0;
+		bool bPawnHit = false;
+		float FirstHitTime = 0.f;
+	};
+
+	static FShotKey MakeShotKey(const FMappedLog& Log, const FShotTelemetryRecord& Record)
+	{
+		FShotKey Key;
+		Key.SessionId = Log.SessionId;
+		Key.WeaponSeed = Record.WeaponSeed;
+		Key.Sequence = Record.Sequence;
+		return Key;
+	}
+
+	static double Percent(int64 Part, int64 Whole)
+	{
+		return Whole > 0 ? 100.0 * Part / Whole : 0.0;
+	}
+
+	/** Logs the percentiles of Values, sorting them in place */
+	static void LogDistribution(const TCHAR* Name, const TCHAR* Unit, TArray<float>& Values)
+	{
+		if (Values.Num() == 0)
+		{
+			UE_LOG(LogTemp, Display, TEXT("  %s: no samples"), Name);
+			return;
+		}
+
+		Values.Sort();
+		auto Percentile = [&Values](double Fraction)
+		{
+			return Values[FMath::Min((int32)(Fraction * Values.Num()), Values.Num() - 1)];
+		};
+		UE_LOG(LogTemp, Display, TEXT("  %s (%s): p50 %.3f  p90 %.3f  p99 %.3f  p99.9 %.3f  max %.3f  (%d samples)"),
+			Name, Unit, Percentile(0.5), Percentile(0.9), Percentile(0.99), Percentile(0.999), Values.Last(), Values.Num());
+	}
+
+	static bool MapLog(const FString& Path, FMappedLog& OutLog)
+	{
+		OutLog.Path = Path;
+		OutLog.Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+		const int64 FileSize = OutLog.Handle.IsValid() ? OutLog.Handle->GetFileSize() : 0;
+		if (FileSize < (int64)sizeof(FShotTelemetryFileHeader))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ShotTelemetry: can't read %s"), *Path);
+			return false;
+		}
+
+		OutLog.Region.Reset(OutLog.Handle->MapRegion(0, FileSize));
+		if (!OutLog.Region.IsValid())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ShotTelemetry: can't map %s"), *Path);
+			return false;
+		}
+
+		const uint8* Data = OutLog.Region->GetMappedPtr();
+		const FShotTelemetryFileHeader& Header = *reinterpret_cast<const FShotTelemetryFileHeader*>(Data);
+		if (Header.Magic != FShotTelemetryFileHeader::ExpectedMagic || Header.Version != FShotTelemetryFileHeader::CurrentVersion
+			|| Header.RecordSize != sizeof(FShotTelemetryRecord))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ShotTelemetry: %s is not a version %d shot log"), *Path, FShotTelemetryFileHeader::CurrentVersion);
+			return false;
+		}
+
+		OutLog.SessionId = Header.SessionId;
+		if (OutLog.SessionId == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ShotTelemetry: %s has no session id, its shots only match logs without one either"), *Path);
+		}
+
+		// A log cut short by a crash ends with a partial record, leave it out
+		OutLog.Records = reinterpret_cast<const FShotTelemetryRecord*>(Data + sizeof(FShotTelemetryFileHeader));
+		OutLog.NumRecords = (FileSize - (int64)sizeof(FShotTelemetryFileHeader)) / (int64)sizeof(FShotTelemetryRecord);
+		return true;
+	}
+}
+
+UShotTelemetryCommandlet::UShotTelemetryCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UShotTelemetryCommandlet::Main(const FString& Params)
+{
+	using namespace ShotTelemetryAnalysis;
+
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	ParseCommandLine(*Params, Tokens, Switches);
+
+	FString Dir = FPaths::ProjectSavedDir() / TEXT("ShotTelemetry");
+	float DivergenceDegrees = 1.f;
+	FParse::Value(*Params, TEXT("Dir="), Dir);
+	FParse::Value(*Params, TEXT("DivergenceDegrees="), DivergenceDegrees);
+
+	TArray<FString> Paths;
+	for (const FString& Token : Tokens)
+	{
+		if (Token.EndsWith(TEXT(".shots")))
+		{
+			Paths.Add(Token);
+		}
+	}
+	if (Paths.Num() == 0)
+	{
+		TArray<FString> FileNames;
+		IFileManager::Get().FindFiles(FileNames, *(Dir / TEXT("*.shots")), true, false);
+		for (const FString& FileName : FileNames)
+		{
+			Paths.Add(Dir / FileName);
+		}
+	}
+
+	// Logs stay mapped until the report is done, the join points into them
+	TArray<FMappedLog> Logs;
+	int64 TotalRecords = 0;
+	for (const FString& Path : Paths)
+	{
+		FMappedLog Log;
+		if (MapLog(Path, Log))
+		{
+			TotalRecords += Log.NumRecords;
+			Logs.Add(MoveTemp(Log));
+		}
+	}
+	if (Logs.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("ShotTelemetry: no shot logs to analyze in %s"), *Dir);
+		return 1;
+	}
+
+	// --- Join the records of every shot -- //
+	TMap<FShotKey, FJoinedShot> Shots;
+	Shots.Reserve((int32)FMath::Min<int64>(TotalRecords / 2, MAX_int32));
+	int64 NumDropped = 0;
+	int64 NumHitRecords = 0;
+	for (const FMappedLog& Log : Logs)
+	{
+		for (int64 Index = 0; Index < Log.NumRecords; ++Index)
+		{
+			const FShotTelemetryRecord& Record = Log.Records[Index];
+			if (Record.Kind == EShotTelemetryKind::Dropped)
+			{
+				NumDropped += Record.Sequence;
+				continue;
+			}
+
+			FJoinedShot& Shot = Shots.FindOrAdd(MakeShotKey(Log, Record));
+			switch (Record.Kind)
+			{
+			case EShotTelemetryKind::Fire:
+				Shot.Fire = Shot.Fire ? Shot.Fire : &Record;
+				break;
+			case EShotTelemetryKind::Process:
+				Shot.Process = Shot.Process ? Shot.Process : &Record;
+				break;
+			case EShotTelemetryKind::Hit:
+				Shot.FirstHitTime = Shot.NumHits > 0 ? FMath::Min(Shot.FirstHitTime, Record.RecordTime) : Record.RecordTime;
+				Shot.bPawnHit |= (Record.Flags & ShotTelemetryFlags::Pawn) != 0;
+				++Shot.NumHits;
+				++NumHitRecords;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	// --- Compare both sides of each shot -- //
+	int64 NumFired = 0;
+	int64 NumProcessed = 0;
+	int64 NumMatched = 0;
+	int64 NumNeverProcessed = 0;
+	int64 NumWithoutFire = 0;
+	int64 NumDivergent = 0;
+	int64 NumSpreadWidened = 0;
+	int64 NumPawnHits = 0;
+	int64 NumWorldHits = 0;
+	int64 NumAimedAtPawn = 0;
+	int64 NumAimedAtPawnServerMissed = 0;
+	TArray<float> AimDivergences;
+	TArray<float> ProcessLatencies;
+	TArray<float> HitLatencies;
+
+	for (const TPair<FShotKey, FJoinedShot>& Pair : Shots)
+	{
+		const FJoinedShot& Shot = Pair.Value;
+		NumFired += Shot.Fire ? 1 : 0;
+
+		if (Shot.Process == nullptr)
+		{
+			NumNeverProcessed += Shot.Fire ? 1 : 0;
+			continue;
+		}
+
+		++NumProcessed;
+		ProcessLatencies.Add((Shot.Process->RecordTime - Shot.Process->ClientFireTime) * 1000.f);
+		if (Shot.NumHits > 0)
+		{
+			HitLatencies.Add((Shot.FirstHitTime - Shot.Process->ClientFireTime) * 1000.f);
+			NumPawnHits += Shot.bPawnHit ? 1 : 0;
+			NumWorldHits += Shot.bPawnHit ? 0 : 1;
+		}
+
+		if (Shot.Fire == nullptr)
+		{
+			++NumWithoutFire;
+			continue;
+		}
+
+		++NumMatched;
+		const float Divergence = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(Shot.Fire->Direction | Shot.Process->Direction, -1.f, 1.f)));
+		AimDivergences.Add(Divergence);
+		NumDivergent += Divergence > DivergenceDegrees ? 1 : 0;
+		NumSpreadWidened += Shot.Process->Spread > Shot.Fire->Spread + 0.01f ? 1 : 0;
+
+		if (Shot.Fire->Flags & ShotTelemetryFlags::Pawn)
+		{
+			++NumAimedAtPawn;
+			NumAimedAtPawnServerMissed += Shot.bPawnHit ? 0 : 1;
+		}
+	}
+
+	// --- Report -- //
+	UE_LOG(LogTemp, Display, TEXT("ShotTelemetry: %d logs, %lld records, %lld dropped by full rings"), Logs.Num(), TotalRecords, NumDropped);
+	UE_LOG(LogTemp, Display, TEXT("Shots"));
+	UE_LOG(LogTemp, Display, TEXT("  fired %lld, processed %lld, matched %lld"), NumFired, NumProcessed, NumMatched);
+	UE_LOG(LogTemp, Display, TEXT("  fired but never processed %lld (%.2f%%), processed without a shooter log %lld"),
+		NumNeverProcessed, Percent(NumNeverProcessed, NumFired), NumWithoutFire);
+	UE_LOG(LogTemp, Display, TEXT("Divergence, over matched shots"));
+	UE_LOG(LogTemp, Display, TEXT("  aim off by more than %.2f deg %lld (%.2f%%), spread widened by the server %lld (%.2f%%)"),
+		DivergenceDegrees, NumDivergent, Percent(NumDivergent, NumMatched), NumSpreadWidened, Percent(NumSpreadWidened, NumMatched));
+	UE_LOG(LogTemp, Display, TEXT("  aimed at a pawn %lld, server hit no pawn %lld (%.2f%%)"),
+		NumAimedAtPawn, NumAimedAtPawnServerMissed, Percent(NumAimedAtPawnServerMissed, NumAimedAtPawn));
+	LogDistribution(TEXT("aim divergence"), TEXT("deg"), AimDivergences);
+	UE_LOG(LogTemp, Display, TEXT("Outcome, over processed shots"));
+	UE_LOG(LogTemp, Display, TEXT("  pawn hit %lld (%.2f%%), world hit %lld (%.2f%%), no hit %lld, %lld bullet hits"),
+		NumPawnHits, Percent(NumPawnHits, NumProcessed), NumWorldHits, Percent(NumWorldHits, NumProcessed),
+		NumProcessed - NumPawnHits - NumWorldHits, NumHitRecords);
+	UE_LOG(LogTemp, Display, TEXT("Latency, server time since the shooter fired"));
+	LogDistribution(TEXT("processed"), TEXT("ms"), ProcessLatencies);
+	LogDistribution(TEXT("first hit"), TEXT("ms"), HitLatencies);
+
+	return 0;
+}
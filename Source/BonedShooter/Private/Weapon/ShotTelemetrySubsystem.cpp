@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/ShotTelemetrySubsystem.h"
+
+#include "Engine/World.h"
+#include "GameplayCore/BonedShooterGameStateBase.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+bool UShotTelemetrySubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	if (!Super::ShouldCreateSubsystem(Outer))
+	{
+		return false;
+	}
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && (World->WorldType == EWorldType::Game || World->WorldType == EWorldType::PIE);
+}
+
+void UShotTelemetrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (!bRecordShots || FParse::Param(FCommandLine::Get(), TEXT("NoShotTelemetry")))
+	{
+		return;
+	}
+
+	// The whole ring up front, recording only ever copies into it
+	Ring.SetNum(FMath::Max(RingCapacity, 64));
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UShotTelemetrySubsystem::OnWorldPostActorTick);
+}
+
+void UShotTelemetrySubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	Flush();
+	LogFile.Reset();
+	Ring.Empty();
+
+	Super::Deinitialize();
+}
+
+void UShotTelemetrySubsystem::Record(const FShotTelemetryRecord& Record)
+{
+	const int32 Capacity = Ring.Num();
+	if (Capacity == 0)
+	{
+		return;
+	}
+
+	if (Head - Tail >= (uint64)Capacity)
+	{
+		++NumDropped;
+		return;
+	}
+
+	Ring[Head % Capacity] = Record;
+	++Head;
+
+	// Don't wait for the interval when a burst fills the ring, drops are what the log is there to avoid. The write
+	// still waits for the end of the frame, the other half of the ring takes the rest of the burst until then.
+	if (Head - Tail >= (uint64)Capacity / 2)
+	{
+		bFlushRequested = true;
+	}
+}
+
+void UShotTelemetrySubsystem::Flush()
+{
+	LastFlushTime = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+	bFlushRequested = false;
+
+	if (Head == Tail && NumDropped == 0)
+	{
+		return;
+	}
+
+	if (!OpenLog())
+	{
+		// Nowhere to write, keep recording from an empty ring. Still waiting for the session id, keep the records.
+		if (bLogFailed)
+		{
+			Tail = Head;
+			NumDropped = 0;
+		}
+		return;
+	}
+
+	// The records of the ring are at most two contiguous spans, before and after the wrap
+	const int32 Capacity = Ring.Num();
+	const int32 Start = (int32)(Tail % Capacity);
+	const int32 Count = (int32)(Head - Tail);
+	const int32 FirstSpan = FMath::Min(Count, Capacity - Start);
+	LogFile->Write(reinterpret_cast<const uint8*>(&Ring[Start]), FirstSpan * sizeof(FShotTelemetryRecord));
+	if (Count > FirstSpan)
+	{
+		LogFile->Write(reinterpret_cast<const uint8*>(Ring.GetData()), (Count - FirstSpan) * sizeof(FShotTelemetryRecord));
+	}
+	Tail = Head;
+
+	if (NumDropped > 0)
+	{
+		FShotTelemetryRecord DroppedRecord;
+		DroppedRecord.Kind = EShotTelemetryKind::Dropped;
+		DroppedRecord.Sequence = NumDropped;
+		DroppedRecord.RecordTime = LastFlushTime;
+		LogFile->Write(reinterpret_cast<const uint8*>(&DroppedRecord), sizeof(DroppedRecord));
+		NumDropped = 0;
+	}
+
+	LogFile->Flush();
+}
+
+void UShotTelemetrySubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld() && (bFlushRequested || World->GetTimeSeconds() - LastFlushTime >= FlushInterval))
+	{
+		Flush();
+	}
+}
+
+bool UShotTelemetrySubsystem::OpenLog()
+{
+	if (LogFile.IsValid() || bLogFailed)
+	{
+		return LogFile.IsValid();
+	}
+
+	// A log without the session id never joins the logs of the other side, wait for the game state to replicate it
+	const UWorld* World = GetWorld();
+	const AGameStateBase* GameStateBase = World->GetGameState();
+	const ABonedShooterGameStateBase* GameState = Cast<ABonedShooterGameStateBase>(GameStateBase);
+	if (GameStateBase == nullptr || (GameState && GameState->GetSessionId() == 0))
+	{
+		return false;
+	}
+
+	const ENetMode NetMode = World->GetNetMode();
+	const TCHAR* Role = NetMode == NM_Client ? TEXT("Client") : NetMode == NM_Standalone ? TEXT("Standalone") : TEXT("Server");
+	const FString Path = FPaths::ProjectSavedDir() / TEXT("ShotTelemetry")
+		/ FString::Printf(TEXT("%s-%s-%u.shots"), Role, *FDateTime::Now().ToString(), FPlatformProcess::GetCurrentProcessId());
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+	LogFile.Reset(PlatformFile.OpenWrite(*Path, true));
+	if (!LogFile.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ShotTelemetry: can't open %s, shots won't be recorded"), *Path);
+		bLogFailed = true;
+		return false;
+	}
+
+	if (GameState == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ShotTelemetry: %s is not an ABonedShooterGameStateBase, %s has no session id"), *GameStateBase->GetClass()->GetName(), *Path);
+	}
+
+	FShotTelemetryFileHeader Header;
+	Header.NetMode = (uint8)NetMode;
+	Header.SessionId = GameState ? GameState->GetSessionId() : 0;
+	Header.StartTicks = FDateTime::UtcNow().GetTicks();
+	LogFile->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+
+	UE_LOG(LogTemp, Log, TEXT("ShotTelemetry: recording to %s"), *Path);
+	return true;
+}
@@ -3,12 +3,30 @@
 
 #include "Weapon/WeaponActor.h"
 
+#include "BonedShooter.h"
 #include "DrawDebugHelpers.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "GameFramework/PlayerState.h"
 #include "GameplayCore/BonedShooterCharacter.h"
+#include "GameplayCore/LagCompensationSubsystem.h"
+#include "GameplayCore/LoadTestSubsystem.h"
+#include "Weapon/AimingComponent.h"
+#include "Weapon/BallisticMovementComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Weapon/Bullet.h"
+#include "Weapon/ProjectilePoolSubsystem.h"
+#include "Weapon/ProjectileSimulationSubsystem.h"
+#include "Weapon/ShotTelemetrySubsystem.h"
+
+// Length of the aim trace, also how far the server probes the client's aim for lag compensation
+static constexpr float AimTraceDistance = 10000.f;
+
+// Bounds of the shot batching protocol, older unacknowledged shots are given up on
+static constexpr int32 MaxShotsPerBatch = 32;
+static constexpr int32 MaxUnackedShots = 64;
 
 // Sets default values
 AWeaponActor::AWeaponActor()
@@ -18,10 +36,34 @@ AWeaponActor::AWeaponActor()
 	RootComponent = WeaponSkeletalMeshComponent;
 	DefaultDamage = 1.f;
 	TimeBetweenShots = .2f;
+	ProjectilePoolPrewarmCount = 32;
+	ProjectileBackend = EProjectileBackend::Actor;
+	ConeDegreesPerSpreadUnit = 0.032f;
+	SpreadTolerance = 0.5f;
+	SpreadSeed = 0;
+	ShotBatchWindow = 0.f;
+	ShotResendInterval = 0.1f;
+	ShotBurstAllowance = 4;
+	FireRateTolerance = 1.1f;
+	MaxMuzzleOffset = 150.f;
+	MaxShotsPerFrame = 16;
+	PelletCount = 1;
+	MinPelletSpread = 3.f;
+	AimTraceMode = EAimTraceMode::Asynchronous;
+	bAimTraceComplex = true;
+
+	// Ticks only while the trigger is held, to run the fire scheduler after the owner has moved
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
 
 	// Replication specs
+	// Only changes on equip: replicated once after spawn and attach, then dormant until the owner aims
 	bReplicates = true;
-	MinNetUpdateFrequency = 33.f;
+	NetDormancy = DORM_DormantAll;
+	NetUpdateFrequency = 33.f;
+	MinNetUpdateFrequency = 2.f;
+	DormancyDelay = 1.f;
 
 }
 
@@ -31,87 +73,510 @@ AWeaponActor::AWeaponActor()
 void AWeaponActor::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	AimTraceDelegate.BindUObject(this, &AWeaponActor::OnAimTraceCompleted);
+
+	// Compile the spread curves once, every shot then only does arithmetic
+	SpreadModel.SetSpecs(FWeaponSpreadSpecs::FromCurveTable(SpreadSpecsTable, DefaultSpreadSpecs));
+
+	if (HasAuthority())
+	{
+		// Also keys the shots in the telemetry, the 15 bits of FMath::Rand would collide between weapons
+		SpreadSeed = (int32)BonedShooterRand32();
+		MARK_PROPERTY_DIRTY_FROM_NAME(AWeaponActor, SpreadSeed, this);
+
+		ShotTokens = ShotBurstAllowance;
+		ShotTokensTime = GetWorld()->GetTimeSeconds();
+	}
+
+	// Bullets are only spawned on the server, fill the pool there before the first shot
+	if (HasAuthority() && ProjectileClass != nullptr && ProjectileBackend == EProjectileBackend::Actor)
+	{
+		if (UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+		{
+			Pool->Prewarm(ProjectileClass, ProjectilePoolPrewarmCount);
+		}
+	}
 }
 
-void AWeaponActor::ServerFire_Implementation(AActor* ProjectileOwner, APawn* ProjectileInstigator, FVector SpawnLocation, FVector ProjectileDestination)
+void AWeaponActor::SetReplicationAwake(bool bAwake)
 {
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.Owner = ProjectileOwner;
-	SpawnParams.Instigator = ProjectileInstigator;
+	if (!HasAuthority())
+	{
+		return;
+	}
 
-	ProjectileDirection = ProjectileDestination-SpawnLocation;
-	ProjectileDirection.Normalize();
-	float BulletSpread = Cast<ABonedShooterCharacter>(GetOwner())->CalculatedSpread;
-	ProjectileDirection = UKismetMathLibrary::RandomUnitVectorInConeInDegrees(ProjectileDirection, BulletSpread);
-	
-	ABullet* Bullet = GetWorld()->SpawnActor<ABullet>(ProjectileClass, SpawnLocation, ProjectileDirection.ToOrientationRotator(), SpawnParams);
-	if (Bullet)
+	if (bAwake)
+	{
+		GetWorldTimerManager().ClearTimer(TimerHandle_Dormancy);
+		SetNetDormancy(DORM_Awake);
+	}
+	else if (NetDormancy == DORM_Awake)
+	{
+		// Late shots still need their acks, give them time to arrive
+		GetWorldTimerManager().SetTimer(TimerHandle_Dormancy, FTimerDelegate::CreateWeakLambda(this, [this]()
+		{
+			SetNetDormancy(DORM_DormantAll);
+		}), DormancyDelay, false);
+	}
+}
+
+void AWeaponActor::ServerFireBatch_Implementation(const FWeaponShotBatch& Batch)
+{
+	BONEDSHOOTER_SCOPE(ServerFireBatch);
+
+	UFireValidationSubsystem* FireValidation = GetWorld()->GetSubsystem<UFireValidationSubsystem>();
+	UNetConnection* Connection = GetNetConnection();
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	if (ULoadTestSubsystem* LoadTest = GetWorld()->GetSubsystem<ULoadTestSubsystem>())
+	{
+		LoadTest->CountIncomingFireBatch();
+	}
+
+	for (int32 Index = 0; Index < Batch.Shots.Num(); ++Index)
+	{
+		// Shots repeated from a previous batch were already simulated. Rejected shots are acknowledged too,
+		// resending them would only be rejected again.
+		const uint32 Sequence = Batch.FirstSequence + Index;
+		const uint32 NumSkipped = Sequence - ReceivedShots.GetLastProcessedSequence() - 1;
+		if (!ReceivedShots.Accept(Sequence))
+		{
+			continue;
+		}
+
+		const FWeaponShot& Shot = Batch.Shots[Index];
+		const EShotRejection Rejection = ValidateShot(Shot, NumSkipped, Now);
+		if (FireValidation)
+		{
+			FireValidation->RecordShot(Connection, Rejection);
+		}
+		if (Rejection == EShotRejection::None)
+		{
+			ProcessShot(Shot, Sequence);
+		}
+		else
+		{
+			BONEDSHOOTER_COUNT(ShotsRejected, 1);
+		}
+	}
+
+	ClientAckShots(ReceivedShots.GetLastProcessedSequence());
+}
+
+bool AWeaponActor::ServerFireBatch_Validate(const FWeaponShotBatch& Batch)
+{
+	return Batch.Shots.Num() <= MaxShotsPerBatch;
+}
+
+EShotRejection AWeaponActor::ValidateShot(const FWeaponShot& Shot, uint32 NumSkipped, float Now)
+{
+	// The seed fields pick the spread, they must follow the previous shot's. A forged shot doesn't take a token.
+	if (!ReceivedShotSeeds.Accept(Shot.BurstSeed, Shot.ShotIndex, NumSkipped))
+	{
+		return EShotRejection::InvalidSeed;
+	}
+
+	// One token per shot, a volley included, refilled at the fire rate over the time between the shots as they were
+	// fired. Shots resent after a loss arrive bunched up but were fired apart, they must not eat into the burst.
+	// GetShotTime keeps fire times within the last second of server time, so they can't run ahead of the wall clock.
+	const float ShotTime = GetShotTime(Shot);
+	const float ShotsPerSecond = FireRateTolerance / FMath::Max(TimeBetweenShots, KINDA_SMALL_NUMBER);
+	ShotTokens = FMath::Min(ShotTokens + FMath::Max(ShotTime - ShotTokensTime, 0.f) * ShotsPerSecond, (float)ShotBurstAllowance);
+	ShotTokensTime = FMath::Max(ShotTokensTime, ShotTime);
+	if (ShotTokens < 1.f)
+	{
+		return EShotRejection::RateLimited;
+	}
+	ShotTokens -= 1.f;
+
+	// The client fired from where it had the muzzle then, the owner may have moved at full speed since
+	const APawn* OwnerPawn = Cast<APawn>(GetOwner());
+	const UPawnMovementComponent* OwnerMovement = OwnerPawn ? OwnerPawn->GetMovementComponent() : nullptr;
+	const float MaxOwnerSpeed = OwnerMovement ? OwnerMovement->GetMaxSpeed() : 0.f;
+	const float ShotAge = Now - GetShotTime(Shot);
+	const float MaxOffset = MaxMuzzleOffset + MaxOwnerSpeed * ShotAge;
+	const FVector MuzzleLocation = WeaponSkeletalMeshComponent->GetSocketLocation(MuzzleSocketName);
+	if (FVector::DistSquared(Shot.Origin, MuzzleLocation) > FMath::Square(MaxOffset))
+	{
+		return EShotRejection::ImplausibleOrigin;
+	}
+
+	return EShotRejection::None;
+}
+
+void AWeaponActor::ClientAckShots_Implementation(uint32 LastProcessedSequence)
+{
+	UnackedShots.Acknowledge(LastProcessedSequence);
+
+	if (UnackedShots.IsEmpty())
+	{
+		GetWorldTimerManager().ClearTimer(TimerHandle_FlushShots);
+		bShotFlushPending = false;
+	}
+}
+
+uint32 AWeaponActor::QueueShot(const FWeaponShot& Shot)
+{
+	// The server doesn't talk to itself
+	if (HasAuthority())
 	{
-		Bullet->LaunchInDirection(ProjectileDirection);
-		Cast<ABonedShooterCharacter>(GetOwner())->OnFired.Broadcast();
+		const uint32 Sequence = ReceivedShots.AcceptLocal();
+		ProcessShot(Shot, Sequence);
+		return Sequence;
+	}
+
+	const uint32 Sequence = UnackedShots.Add(Shot, MaxUnackedShots);
+
+	// Collect the shots of this frame, or of the batch window, into one message
+	if (!bShotFlushPending)
+	{
+		bShotFlushPending = true;
+
+		// Replaces a pending retransmission, the flush sends those shots too
+		FTimerManager& TimerManager = GetWorldTimerManager();
+		TimerManager.ClearTimer(TimerHandle_FlushShots);
+		if (ShotBatchWindow > 0.f)
+		{
+			TimerManager.SetTimer(TimerHandle_FlushShots, this, &AWeaponActor::FlushShots, ShotBatchWindow, false);
+		}
+		else
+		{
+			TimerHandle_FlushShots = TimerManager.SetTimerForNextTick(this, &AWeaponActor::FlushShots);
+		}
+	}
+
+	return Sequence;
+}
+
+void AWeaponActor::FlushShots()
+{
+	bShotFlushPending = false;
+	FWeaponShotBatch Batch;
+	if (!UnackedShots.MakeBatch(MaxShotsPerBatch, Batch))
+	{
+		return;
+	}
+	ServerFireBatch(Batch);
+
+	// Keep sending until the server acknowledges, the ack clears this timer
+	GetWorldTimerManager().SetTimer(TimerHandle_FlushShots, this, &AWeaponActor::FlushShots, ShotResendInterval, false);
+}
+
+void AWeaponActor::ProcessShot(const FWeaponShot& Shot, uint32 Sequence)
+{
+	BONEDSHOOTER_SCOPE(ProcessShot);
+	BONEDSHOOTER_COUNT(ShotsProcessed, 1);
+
+	const FVector SpawnLocation = Shot.Origin;
+	FVector ProjectileDestination = SpawnLocation + Shot.AimDirection * AimTraceDistance;
+
+	// Check the client's aim against the world it saw, instead of the present-time one. Once for the whole volley.
+	if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		// No connection for the shots of the listen server's player and of bots, they see the present
+		const float ViewTime = LagCompensation->GetClientViewTime(Shot.ClientFireTime, GetNetConnection());
+		ProjectileDestination = LagCompensation->ResolveShotDestination(SpawnLocation, ProjectileDestination, ViewTime, GetOwner());
+	}
+
+	// Sampled from the quantized spread, the one clients get to draw the cosmetic pellets. A batch carries shots fired
+	// over several frames, each one is judged and counted at the time it was fired, not at the time it arrived.
+	const float ShotTime = GetShotTime(Shot);
+	FWeaponShot ValidatedShot = Shot;
+	ValidatedShot.SetSpread(GetValidatedSpread(Shot, ShotTime));
+	const FVector AimAxis = (ProjectileDestination - SpawnLocation).GetSafeNormal();
+	const int32 Seed = FWeaponConeSampler::MakeSeed(SpreadSeed, Shot.BurstSeed, Shot.ShotIndex);
+
+	TArray<FVector, TInlineAllocator<WEAPON_MAX_PELLETS>> PelletDirections;
+	PelletDirections.SetNumUninitialized(GetNumPellets());
+	ComputePelletDirections(AimAxis, ValidatedShot.GetSpread(), Seed, PelletDirections);
+	SpreadModel.RecordShot(ShotTime);
+
+	if (UShotTelemetrySubsystem* Telemetry = GetWorld()->GetSubsystem<UShotTelemetrySubsystem>())
+	{
+		FShotTelemetryRecord Record;
+		Record.Kind = EShotTelemetryKind::Process;
+		Record.NumPellets = (uint8)PelletDirections.Num();
+		Record.ShooterId = GetShooterId();
+		Record.WeaponSeed = SpreadSeed;
+		Record.Sequence = Sequence;
+		Record.ClientFireTime = Shot.ClientFireTime;
+		Record.RecordTime = GetWorld()->GetTimeSeconds();
+		Record.Spread = ValidatedShot.GetSpread();
+		Record.Direction = AimAxis;
+		Record.SpreadDirection = PelletDirections[0];
+		Record.Location = SpawnLocation;
+		Telemetry->Record(Record);
+	}
+
+	AActor* ProjectileOwner = this;
+	APawn* ProjectileInstigator = GetInstigator();
+
+	// Bots and tests may hold the weapon with another actor, and the owner can go away in the middle of a batch
+	ABonedShooterCharacter* OwnerCharacter = Cast<ABonedShooterCharacter>(GetOwner());
+
+	if (ProjectileBackend == EProjectileBackend::Batched)
+	{
+		UProjectileSimulationSubsystem* Simulation = GetWorld()->GetSubsystem<UProjectileSimulationSubsystem>();
+		if (Simulation == nullptr || ProjectileClass == nullptr)
+		{
+			return;
+		}
+
+		// Ballistics and flight time still come from the bullet Blueprint so both backends behave the same
+		const ABullet* BulletDefaults = ProjectileClass->GetDefaultObject<ABullet>();
+		const UBallisticMovementComponent* Ballistics = BulletDefaults->BallisticMovementComponent;
+		const float GravityZ = GetWorld()->GetGravityZ() * Ballistics->GravityScale;
+
+		// Pellets join the simulation's buffers together and are swept in its next parallel batch
+		for (const FVector& PelletDirection : PelletDirections)
+		{
+			Simulation->SpawnProjectile(SpawnLocation, PelletDirection * Ballistics->InitialSpeed, GravityZ, Ballistics->Drag,
+				BulletDefaults->InitialLifeSpan, ProjectileOwner, ProjectileInstigator, Sequence);
+		}
+		BONEDSHOOTER_COUNT(BulletsSpawned, PelletDirections.Num());
+		MulticastSpawnCosmeticVolley(SpawnLocation, AimAxis, ValidatedShot.QuantizedSpread, Seed);
+		if (OwnerCharacter)
+		{
+			OwnerCharacter->OnFired.Broadcast();
+		}
+		return;
+	}
+
+	UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>();
+	if (Pool == nullptr)
+	{
+		return;
+	}
+
+	bool bFired = false;
+	for (const FVector& PelletDirection : PelletDirections)
+	{
+		const FTransform SpawnTransform(PelletDirection.ToOrientationRotator(), SpawnLocation);
+		ABullet* Bullet = Pool->AcquireBullet(ProjectileClass, SpawnTransform, ProjectileOwner, ProjectileInstigator);
+		if (Bullet)
+		{
+			Bullet->SetCosmeticOnly(false);
+			Bullet->ShotSequence = Sequence;
+			Bullet->LaunchInDirection(PelletDirection);
+			BONEDSHOOTER_COUNT(BulletsSpawned, 1);
+			bFired = true;
+		}
+	}
+
+	if (bFired && OwnerCharacter)
+	{
+		OwnerCharacter->OnFired.Broadcast();
 	}
 	
 }
 
-bool AWeaponActor::ServerFire_Validate(AActor* ProjectileOwner, APawn* ProjectileInstigator, FVector SpawnLocation, FVector ProjectileDestination)
+void AWeaponActor::MulticastSpawnCosmeticVolley_Implementation(FVector_NetQuantize SpawnLocation, FVector_NetQuantizeNormal AimAxis, uint16 QuantizedSpread, int32 Seed)
 {
-	return true;
+	// Nobody looks at a dedicated server
+	if (GetNetMode() == NM_DedicatedServer || ProjectileClass == nullptr)
+	{
+		return;
+	}
+
+	UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>();
+	if (Pool == nullptr)
+	{
+		return;
+	}
+
+	FWeaponShot Volley;
+	Volley.QuantizedSpread = QuantizedSpread;
+
+	TArray<FVector, TInlineAllocator<WEAPON_MAX_PELLETS>> PelletDirections;
+	PelletDirections.SetNumUninitialized(GetNumPellets());
+	ComputePelletDirections(AimAxis, Volley.GetSpread(), Seed, PelletDirections);
+
+	for (const FVector& PelletDirection : PelletDirections)
+	{
+		const FTransform SpawnTransform(PelletDirection.ToOrientationRotator(), SpawnLocation);
+		if (ABullet* Bullet = Pool->AcquireBullet(ProjectileClass, SpawnTransform, this, GetInstigator()))
+		{
+			Bullet->SetCosmeticOnly(true);
+			Bullet->LaunchInDirection(PelletDirection);
+		}
+	}
+}
+
+int32 AWeaponActor::GetShooterId() const
+{
+	const APawn* OwnerPawn = Cast<APawn>(GetOwner());
+	const APlayerState* OwnerPlayerState = OwnerPawn ? OwnerPawn->GetPlayerState() : nullptr;
+	return OwnerPlayerState ? OwnerPlayerState->GetPlayerId() : -1;
+}
+
+float AWeaponActor::GetValidatedSpread(const FWeaponShot& Shot, float ShotTime) const
+{
+	// Trust the client's spread unless it is tighter than ours by more than timing differences explain
+	float Spread = Shot.GetSpread();
+	if (HasAuthority())
+	{
+		Spread = FMath::Max(Spread, GetSpreadConeHalfAngleAt(ShotTime) - SpreadTolerance);
+	}
+	return Spread;
+}
+
+float AWeaponActor::GetShotTime(const FWeaponShot& Shot) const
+{
+	// ClientFireTime is the client's estimate of the server time, a lying or badly synced client only gets a second
+	const float Now = GetWorld()->GetTimeSeconds();
+	return FMath::Clamp(Shot.ClientFireTime, Now - 1.f, Now);
+}
+
+void AWeaponActor::ComputePelletDirections(const FVector& AimAxis, float Spread, int32 Seed, TArrayView<FVector> OutDirections) const
+{
+	// A single bullet follows the weapon spread, pellets never bunch up tighter than MinPelletSpread
+	const float ConeHalfAngle = OutDirections.Num() > 1 ? FMath::Max(Spread, MinPelletSpread) : Spread;
+	FWeaponConeSampler::SampleDirections(AimAxis, ConeHalfAngle, Seed, OutDirections);
+}
+
+float AWeaponActor::GetCurrentSpread() const
+{
+	return GetSpreadAt(GetWorld()->GetTimeSeconds());
+}
+
+float AWeaponActor::GetSpreadAt(float Time) const
+{
+	const ABonedShooterCharacter* OwnerCharacter = Cast<ABonedShooterCharacter>(GetOwner());
+	const float Speed = OwnerCharacter ? OwnerCharacter->GetVelocity().Size() : 0.f;
+	const bool bIsAiming = OwnerCharacter && OwnerCharacter->IsAiming();
+	return SpreadModel.Evaluate(Time, Speed, bIsAiming);
+}
+
+float AWeaponActor::GetSpreadConeHalfAngle() const
+{
+	return GetSpreadConeHalfAngleAt(GetWorld()->GetTimeSeconds());
+}
+
+float AWeaponActor::GetSpreadConeHalfAngleAt(float Time) const
+{
+	return GetSpreadAt(Time) * ConeDegreesPerSpreadUnit;
 }
 
 void AWeaponActor::StartFire()
 {
-	const bool bDoLoop = true;
-	const float FirstDelay = FMath::Max((LastFireTime - GetWorld()->TimeSeconds + TimeBetweenShots), 0.f);
-	GetWorldTimerManager().SetTimer(TimerHandle_AutoFire, this, &AWeaponActor::Fire, TimeBetweenShots, bDoLoop, FirstDelay);
+	++BurstSeed;
+	ShotIndexInBurst = 0;
+
+	// Shots between two frames are placed along the way from the previous frame's viewpoint to the current one
+	CacheShotViewpoint();
+	const float Now = GetWorld()->GetTimeSeconds();
+	FireScheduler.Start(Now, TimeBetweenShots, LastFireTime + TimeBetweenShots);
+	SetActorTickEnabled(true);
 }
 
 void AWeaponActor::EndFire()
 {
-	GetWorldTimerManager().ClearTimer(TimerHandle_AutoFire);
+	FireScheduler.Stop();
+	SetActorTickEnabled(false);
+}
+
+void AWeaponActor::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	TArray<float, TInlineAllocator<16>> ShotTimes;
+	FireScheduler.Advance(Now, MaxShotsPerFrame, ShotTimes);
+
+	for (const float ShotTime : ShotTimes)
+	{
+		const float FrameAlpha = DeltaSeconds > 0.f ? FMath::Clamp(1.f - (Now - ShotTime) / DeltaSeconds, 0.f, 1.f) : 1.f;
+		FireShot(ShotTime, FrameAlpha);
+	}
+
+	CacheShotViewpoint();
+}
+
+void AWeaponActor::CacheShotViewpoint()
+{
+	if (IsValid(GetOwner()))
+	{
+		GetOwner()->GetActorEyesViewPoint(PreviousEyeLocation, PreviousEyeRotation);
+		PreviousMuzzleLocation = WeaponSkeletalMeshComponent->GetSocketLocation(MuzzleSocketName);
+	}
 }
 
 void AWeaponActor::Fire()
 {
+	FireShot(GetWorld()->GetTimeSeconds(), 1.f);
+}
+
+void AWeaponActor::FireShot(float ShotTime, float FrameAlpha)
+{
+	BONEDSHOOTER_SCOPE(WeaponFire);
+
 		// Do the following on the client owner as well so that there is a minimal amount of latency when firing
 	if (IsValid(GetOwner()))
 	{
-		LastFireTime = GetWorld()->TimeSeconds;
+		LastFireTime = ShotTime;
 
 		// Hit-Scan Weapon: Trace the world from our Pawn point of view (camera) toward crosshair direction
 		FVector TraceStart;
 		FRotator ViewpointOrientation;
 		GetOwner()->GetActorEyesViewPoint(TraceStart, ViewpointOrientation);
+		FVector MuzzleLocation = WeaponSkeletalMeshComponent->GetSocketLocation(MuzzleSocketName);
+		if (FrameAlpha < 1.f)
+		{
+			TraceStart = FMath::Lerp(PreviousEyeLocation, TraceStart, FrameAlpha);
+			ViewpointOrientation = FQuat::Slerp(PreviousEyeRotation.Quaternion(), ViewpointOrientation.Quaternion(), FrameAlpha).Rotator();
+			MuzzleLocation = FMath::Lerp(PreviousMuzzleLocation, MuzzleLocation, FrameAlpha);
+		}
 		const FVector ShotDirection = ViewpointOrientation.Vector();
-		const FVector TraceEnd = TraceStart + ShotDirection * 10000.f;
+		const FVector TraceEnd = TraceStart + ShotDirection * AimTraceDistance;
 
+		if (ProjectileClass != nullptr)
+		{
+			// Shots due earlier in the frame carry their own time, not the time of the frame
+			const float ShotAge = GetWorld()->GetTimeSeconds() - ShotTime;
 
-		FCollisionQueryParams QueryParams;
-		QueryParams.AddIgnoredActor(GetOwner());
-		QueryParams.AddIgnoredActor(this);
-		QueryParams.bTraceComplex = true;
-		QueryParams.bReturnPhysicalMaterial = true;
+			BONEDSHOOTER_COUNT(ShotsFired, 1);
 
-		FHitResult CameraTargetHitResult;
-		bool bFirstHit = GetWorld()->LineTraceSingleByChannel(CameraTargetHitResult, TraceStart, TraceEnd, ECollisionChannel::ECC_Visibility, QueryParams);
+			FWeaponShot Shot;
+			Shot.Origin = MuzzleLocation;
+			Shot.BurstSeed = BurstSeed;
+			Shot.ShotIndex = ShotIndexInBurst++;
+			Shot.SetSpread(GetSpreadConeHalfAngleAt(ShotTime));
+			Shot.ClientFireTime = ULagCompensationSubsystem::GetLagCompensationTime(GetWorld()) - ShotAge;
 
+			// The server records its own shots in ProcessShot, clients predict theirs for the crosshair
+			if (!HasAuthority())
+			{
+				SpreadModel.RecordShot(ShotTime);
+			}
 
-		if (ProjectileClass != nullptr)
-		{
-			FVector ProjectileTarget;
-			if (bFirstHit)
+			// The crosshair already traced from this very viewpoint this frame, aim where it points
+			UAimingComponent* AimingComponent = GetOwner()->FindComponentByClass<UAimingComponent>();
+			if (FrameAlpha >= 1.f && AimingComponent && AimingComponent->HasAimSolutionThisFrame())
 			{
-				ProjectileTarget = CameraTargetHitResult.Location;
+				const FAimSolution& AimSolution = AimingComponent->GetAimSolution();
+				CompleteShot(Shot, MuzzleLocation, AimSolution.HitLocation, AimSolution.bHit, AimSolution.HitActor);
 			}
-			
-			if (!bFirstHit)
+			else if (AimTraceMode == EAimTraceMode::Synchronous)
 			{
-				ProjectileTarget = TraceEnd;				
+				BONEDSHOOTER_COUNT(AimTraces, 1);
+				FHitResult CameraTargetHitResult;
+				const bool bFirstHit = GetWorld()->LineTraceSingleByChannel(CameraTargetHitResult, TraceStart, TraceEnd, ECollisionChannel::ECC_Visibility, GetAimQueryParams());
+				CompleteShot(Shot, MuzzleLocation, bFirstHit ? CameraTargetHitResult.Location : TraceEnd, bFirstHit, CameraTargetHitResult.GetActor());
 			}
-			// Now we can spawn projectile
-			FVector MuzzleLocation = WeaponSkeletalMeshComponent->GetSocketLocation(MuzzleSocketName);
+			else
+			{
+				// Every trace requested this frame runs in the same async batch, results come back at the start of the next frame
+				BONEDSHOOTER_COUNT(AimTraces, 1);
+				const uint32 TraceKey = NextAimTraceKey++;
+				FPendingAimShot& PendingShot = PendingAimShots.Add(TraceKey);
+				PendingShot.Shot = Shot;
+				PendingShot.MuzzleLocation = MuzzleLocation;
+				PendingShot.TraceEnd = TraceEnd;
 
-			ServerFire(this, GetOwner()->GetInstigator(), MuzzleLocation, ProjectileTarget);
+				GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, TraceStart, TraceEnd, ECollisionChannel::ECC_Visibility,
+					GetAimQueryParams(), FCollisionResponseParams::DefaultResponseParam, &AimTraceDelegate, TraceKey);
+			}
 		}
 	}
 	else
@@ -121,15 +586,67 @@ void AWeaponActor::Fire()
 }
 
 
+void AWeaponActor::OnAimTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	FPendingAimShot PendingShot;
+	if (!PendingAimShots.RemoveAndCopyValue(TraceDatum.UserData, PendingShot) || !IsValid(GetOwner()))
+	{
+		return;
+	}
+
+	const FHitResult* CameraTargetHitResult = TraceDatum.OutHits.Num() > 0 && TraceDatum.OutHits[0].bBlockingHit ? &TraceDatum.OutHits[0] : nullptr;
+	CompleteShot(PendingShot.Shot, PendingShot.MuzzleLocation, CameraTargetHitResult ? CameraTargetHitResult->Location : PendingShot.TraceEnd,
+		CameraTargetHitResult != nullptr, CameraTargetHitResult ? CameraTargetHitResult->GetActor() : nullptr);
+}
+
+void AWeaponActor::CompleteShot(FWeaponShot& Shot, const FVector& MuzzleLocation, const FVector& ProjectileTarget, bool bAimHit, const AActor* AimHitActor)
+{
+	Shot.AimDirection = (ProjectileTarget - MuzzleLocation).GetSafeNormal();
+	const uint32 Sequence = QueueShot(Shot);
+
+	if (UShotTelemetrySubsystem* Telemetry = GetWorld()->GetSubsystem<UShotTelemetrySubsystem>())
+	{
+		FShotTelemetryRecord Record;
+		Record.Kind = EShotTelemetryKind::Fire;
+		Record.Flags = (bAimHit ? ShotTelemetryFlags::Blocked : 0) | (Cast<APawn>(AimHitActor) ? ShotTelemetryFlags::Pawn : 0);
+		Record.NumPellets = (uint8)GetNumPellets();
+		Record.ShooterId = GetShooterId();
+		Record.WeaponSeed = SpreadSeed;
+		Record.Sequence = Sequence;
+		Record.ClientFireTime = Shot.ClientFireTime;
+		Record.RecordTime = GetWorld()->GetTimeSeconds();
+		Record.Spread = Shot.GetSpread();
+		Record.Direction = Shot.AimDirection;
+		Record.Location = ProjectileTarget;
+		Telemetry->Record(Record);
+	}
+}
+
+const FCollisionQueryParams& AWeaponActor::GetAimQueryParams()
+{
+	// Only the ignored actors can change, and only when the weapon changes hands
+	if (AimQueryParamsOwner != GetOwner())
+	{
+		AimQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(WeaponAimTrace), bAimTraceComplex);
+		AimQueryParams.AddIgnoredActor(GetOwner());
+		AimQueryParams.AddIgnoredActor(this);
+		AimQueryParamsOwner = GetOwner();
+	}
+	return AimQueryParams;
+}
+
 
 void AWeaponActor::GetLifetimeReplicatedProps(TArray<FLifetimeProperty> & OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AWeaponActor, HandleSocketName);
-	DOREPLIFETIME(AWeaponActor, MuzzleSocketName);
-	DOREPLIFETIME(AWeaponActor, WeaponSkeletalMeshComponent);
-	DOREPLIFETIME(AWeaponActor, ProjectileDirection);
+	// Push model: these are set once, the sockets and mesh in the defaults and the seed at BeginPlay
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AWeaponActor, HandleSocketName, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AWeaponActor, MuzzleSocketName, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AWeaponActor, WeaponSkeletalMeshComponent, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AWeaponActor, SpreadSeed, Params);
 	
 
 }
@@ -0,0 +1,417 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/WeaponBenchmarkCommandlet.h"
+
+#include "Components/StaticMeshComponent.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Weapon/BallisticMovementComponent.h"
+#include "Weapon/Bullet.h"
+#include "Weapon/ProjectilePoolSubsystem.h"
+#include "Weapon/ProjectileSimulationSubsystem.h"
+#include "Weapon/WeaponActor.h"
+#include "Weapon/WeaponShot.h"
+#include "Weapon/WeaponSpreadModel.h"
+
+// Results of the timed loops end up here, so the optimizer can't drop the work
+static volatile float GWeaponBenchmarkSink = 0.f;
+
+// Fixed frame time of the world ticks, the firefight is the same sequence of frames on every run
+static constexpr float BenchmarkDeltaTime = 1.f / 30.f;
+
+// The two walls of the firefight face each other across the X axis
+static constexpr float ArenaHalfLength = 8000.f;
+static constexpr float ArenaHalfWidth = 2000.f;
+static constexpr float ShooterHeight = 300.f;
+
+UWeaponBenchmarkCommandlet::UWeaponBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UWeaponBenchmarkCommandlet::Main(const FString& Params)
+{
+	if (GEngine == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("WeaponBenchmark: needs an engine"));
+		return 1;
+	}
+
+	FString OutputPath = FPaths::ProjectSavedDir() / DefaultOutputFile;
+	FString BaselinePath = FPaths::ProjectDir() / DefaultBaselineFile;
+	float RunTolerance = Tolerance;
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+	FParse::Value(*Params, TEXT("Tolerance="), RunTolerance);
+	const bool bUpdateBaseline = FParse::Param(*Params, TEXT("UpdateBaseline"));
+
+	TSubclassOf<ABullet> ProjectileClass = BulletClass.TryLoadClass<ABullet>();
+	if (ProjectileClass == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("WeaponBenchmark: can't load %s, using the native bullet"), *BulletClass.ToString());
+		ProjectileClass = ABullet::StaticClass();
+	}
+
+	// The empty test map: a transient game world holding nothing but the arena
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("WeaponBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	BuildArena(World);
+
+	// No game mode starts play in this world, do what its StartPlay would
+	World->GetWorldSettings()->NotifyBeginPlay();
+	World->BeginPlay();
+
+	Metrics.Reset();
+	RunConeSampling();
+	RunSpreadEvaluation();
+	RunAimTrace(World);
+	RunBulletLaunch(World, ProjectileClass);
+	RunFirefight(World, ProjectileClass, false);
+	RunFirefight(World, ProjectileClass, true);
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	for (const FWeaponBenchmarkMetric& Metric : Metrics)
+	{
+		UE_LOG(LogTemp, Display, TEXT("WeaponBenchmark: %-48s %12.3f"), *Metric.Name, Metric.Value);
+	}
+
+	if (!WriteResults(OutputPath))
+	{
+		return 1;
+	}
+
+	if (bUpdateBaseline)
+	{
+		return WriteResults(BaselinePath) ? 0 : 1;
+	}
+
+	return CompareAgainstBaseline(BaselinePath, RunTolerance) ? 0 : 1;
+}
+
+void UWeaponBenchmarkCommandlet::RunMicro(const TCHAR* Name, TFunctionRef<void(int32)> Body)
+{
+	const int32 NumIterations = FMath::Max(MicroIterations, 1);
+
+	// One untimed pass to fault the code and data in
+	Body(NumIterations);
+
+	TArray<double> NsPerIteration;
+	for (int32 Repetition = 0; Repetition < FMath::Max(MicroRepetitions, 1); ++Repetition)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		Body(NumIterations);
+		NsPerIteration.Add((FPlatformTime::Seconds() - StartTime) * 1e9 / NumIterations);
+	}
+
+	// The median shrugs off the repetitions the OS interrupted
+	NsPerIteration.Sort();
+
+	FWeaponBenchmarkMetric& Metric = Metrics.AddDefaulted_GetRef();
+	Metric.Name = FString::Printf(TEXT("Micro.%s.NsPerCall"), Name);
+	Metric.Value = NsPerIteration[NsPerIteration.Num() / 2];
+}
+
+void UWeaponBenchmarkCommandlet::RunConeSampling()
+{
+	const FVector Axis = FVector(1.f, 1.f, 0.2f).GetSafeNormal();
+
+	RunMicro(TEXT("ConeSampling.Single"), [&Axis](int32 NumIterations)
+	{
+		FVector Direction;
+		float Sum = 0.f;
+		for (int32 Index = 0; Index < NumIterations; ++Index)
+		{
+			FWeaponConeSampler::SampleDirections(Axis, 2.f, Index, MakeArrayView(&Direction, 1));
+			Sum += Direction.X;
+		}
+		GWeaponBenchmarkSink = Sum;
+	});
+
+	RunMicro(TEXT("ConeSampling.Volley8"), [&Axis](int32 NumIterations)
+	{
+		FVector Directions[8];
+		float Sum = 0.f;
+		for (int32 Index = 0; Index < NumIterations; ++Index)
+		{
+			FWeaponConeSampler::SampleDirections(Axis, 5.f, Index, Directions);
+			Sum += Directions[7].X;
+		}
+		GWeaponBenchmarkSink = Sum;
+	});
+}
+
+void UWeaponBenchmarkCommandlet::RunSpreadEvaluation()
+{
+	// What a shot costs the spread: the crosshair's evaluation, then the shot's own heat
+	RunMicro(TEXT("SpreadEvaluation"), [](int32 NumIterations)
+	{
+		FWeaponSpreadModel SpreadModel;
+		SpreadModel.SetSpecs(FWeaponSpreadSpecs());
+		float Sum = 0.f;
+		for (int32 Index = 0; Index < NumIterations; ++Index)
+		{
+			const float Now = Index * 0.1f;
+			Sum += SpreadModel.Evaluate(Now, (Index % 8) * 100.f, (Index & 1) != 0);
+			SpreadModel.RecordShot(Now);
+		}
+		GWeaponBenchmarkSink = Sum;
+	});
+}
+
+void UWeaponBenchmarkCommandlet::RunAimTrace(UWorld* World)
+{
+	// A bare weapon held by a bare actor, the trace of FireShot against the arena's far wall
+	AActor* Holder = World->SpawnActor<AStaticMeshActor>(FVector(-ArenaHalfLength + 200.f, 0.f, ShooterHeight), FRotator::ZeroRotator);
+	AWeaponActor* Weapon = World->SpawnActor<AWeaponActor>(Holder->GetActorLocation(), FRotator::ZeroRotator);
+	Weapon->SetOwner(Holder);
+
+	const FVector TraceStart = Holder->GetActorLocation();
+	RunMicro(TEXT("AimTrace"), [World, Weapon, &TraceStart](int32 NumIterations)
+	{
+		FHitResult Hit;
+		float Sum = 0.f;
+		for (int32 Index = 0; Index < NumIterations; ++Index)
+		{
+			const FVector Direction = FRotator((Index % 7) - 3.f, (Index % 31) - 15.f, 0.f).Vector();
+			World->LineTraceSingleByChannel(Hit, TraceStart, TraceStart + Direction * 10000.f, ECC_Visibility, Weapon->GetAimQueryParams());
+			Sum += Hit.Distance;
+		}
+		GWeaponBenchmarkSink = Sum;
+	});
+
+	Weapon->Destroy();
+	Holder->Destroy();
+}
+
+void UWeaponBenchmarkCommandlet::RunBulletLaunch(UWorld* World, TSubclassOf<ABullet> ProjectileClass)
+{
+	UProjectilePoolSubsystem* Pool = World->GetSubsystem<UProjectilePoolSubsystem>();
+	if (Pool == nullptr)
+	{
+		return;
+	}
+	Pool->Prewarm(ProjectileClass, 8);
+
+	// Out of the pool, launched, and straight back: what ProcessShot pays per pellet on the actor backend
+	const FTransform SpawnTransform(FVector(-ArenaHalfLength + 200.f, 0.f, ShooterHeight));
+	RunMicro(TEXT("BulletLaunch"), [Pool, ProjectileClass, &SpawnTransform](int32 NumIterations)
+	{
+		for (int32 Index = 0; Index < NumIterations; ++Index)
+		{
+			if (ABullet* Bullet = Pool->AcquireBullet(ProjectileClass, SpawnTransform, nullptr, nullptr))
+			{
+				Bullet->SetCosmeticOnly(false);
+				Bullet->LaunchInDirection(FVector::ForwardVector);
+				Pool->ReleaseBullet(Bullet);
+			}
+		}
+	});
+}
+
+void UWeaponBenchmarkCommandlet::RunFirefight(UWorld* World, TSubclassOf<ABullet> ProjectileClass, bool bBatched)
+{
+	UProjectilePoolSubsystem* Pool = World->GetSubsystem<UProjectilePoolSubsystem>();
+	UProjectileSimulationSubsystem* Simulation = World->GetSubsystem<UProjectileSimulationSubsystem>();
+	if (Pool == nullptr || Simulation == nullptr)
+	{
+		return;
+	}
+
+	const ABullet* BulletDefaults = ProjectileClass->GetDefaultObject<ABullet>();
+	const UBallisticMovementComponent* Ballistics = BulletDefaults->BallisticMovementComponent;
+	const float GravityZ = World->GetGravityZ() * Ballistics->GravityScale;
+	if (!bBatched)
+	{
+		Pool->Prewarm(ProjectileClass, FirefightBullets);
+	}
+
+	// Same seed on every run: every run fires the same bullets along the same lines
+	FRandomStream Stream(0x5EED);
+	const int32 SpawnFrames = FMath::Max(FirefightSpawnFrames, 1);
+	const int32 NumFrames = FMath::Max(FirefightFrames, SpawnFrames);
+	int32 NumFired = 0;
+	double TotalMs = 0.0;
+	double PeakMs = 0.0;
+
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		// Two lines of shooters across the arena, firing at each other
+		const int32 FireUpTo = Frame < SpawnFrames ? FirefightBullets * (Frame + 1) / SpawnFrames : NumFired;
+		for (; NumFired < FireUpTo; ++NumFired)
+		{
+			const float Side = (NumFired & 1) ? 1.f : -1.f;
+			const FVector Origin(Side * (ArenaHalfLength - 200.f), Stream.FRandRange(-ArenaHalfWidth, ArenaHalfWidth) * 0.8f, ShooterHeight);
+			const FVector Target(-Side * ArenaHalfLength, Stream.FRandRange(-ArenaHalfWidth, ArenaHalfWidth) * 0.8f, ShooterHeight);
+
+			FVector Direction;
+			FWeaponConeSampler::SampleDirections((Target - Origin).GetSafeNormal(), 1.f, NumFired, MakeArrayView(&Direction, 1));
+
+			if (bBatched)
+			{
+				Simulation->SpawnProjectile(Origin, Direction * Ballistics->InitialSpeed, GravityZ, Ballistics->Drag,
+					BulletDefaults->InitialLifeSpan, nullptr, nullptr, NumFired);
+			}
+			else if (ABullet* Bullet = Pool->AcquireBullet(ProjectileClass, FTransform(Direction.ToOrientationRotator(), Origin), nullptr, nullptr))
+			{
+				Bullet->SetCosmeticOnly(false);
+				Bullet->LaunchInDirection(Direction);
+			}
+		}
+
+		World->Tick(LEVELTICK_All, BenchmarkDeltaTime);
+
+		const double FrameMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		TotalMs += FrameMs;
+		PeakMs = FMath::Max(PeakMs, FrameMs);
+	}
+
+	const int32 LeftInFlight = bBatched ? Simulation->GetNumProjectiles() : Pool->GetNumActive();
+	if (LeftInFlight > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("WeaponBenchmark: %d bullets still in flight after %d frames, raise FirefightFrames"), LeftInFlight, NumFrames);
+	}
+
+	const FString Prefix = FString::Printf(TEXT("Macro.Firefight%d.%s"), FirefightBullets, bBatched ? TEXT("Batched") : TEXT("Actor"));
+
+	FWeaponBenchmarkMetric& AverageMetric = Metrics.AddDefaulted_GetRef();
+	AverageMetric.Name = Prefix + TEXT(".AvgFrameMs");
+	AverageMetric.Value = TotalMs / NumFrames;
+
+	FWeaponBenchmarkMetric& PeakMetric = Metrics.AddDefaulted_GetRef();
+	PeakMetric.Name = Prefix + TEXT(".PeakFrameMs");
+	PeakMetric.Value = PeakMs;
+	PeakMetric.bGated = false;
+}
+
+void UWeaponBenchmarkCommandlet::BuildArena(UWorld* World)
+{
+	UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (Cube == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("WeaponBenchmark: can't load the engine cube, the bullets will hit nothing"));
+		return;
+	}
+
+	// The cube is 100 units wide, scales are in hundreds of units
+	auto AddBlock = [World, Cube](const FVector& Location, const FVector& Scale)
+	{
+		AStaticMeshActor* Block = World->SpawnActor<AStaticMeshActor>(Location, FRotator::ZeroRotator);
+		Block->GetStaticMeshComponent()->SetStaticMesh(Cube);
+		Block->SetActorScale3D(Scale);
+	};
+
+	AddBlock(FVector(0.f, 0.f, -50.f), FVector(ArenaHalfLength / 50.f, ArenaHalfWidth / 50.f, 1.f));
+	AddBlock(FVector(-ArenaHalfLength - 50.f, 0.f, 500.f), FVector(1.f, ArenaHalfWidth / 50.f, 10.f));
+	AddBlock(FVector(ArenaHalfLength + 50.f, 0.f, 500.f), FVector(1.f, ArenaHalfWidth / 50.f, 10.f));
+
+	// Cover in front of each wall, so hits land at different depths
+	FRandomStream Stream(0xC0BE);
+	for (int32 Index = 0; Index < 16; ++Index)
+	{
+		const float Side = (Index & 1) ? 1.f : -1.f;
+		const FVector Location(Side * Stream.FRandRange(ArenaHalfLength * 0.5f, ArenaHalfLength * 0.9f),
+			Stream.FRandRange(-ArenaHalfWidth, ArenaHalfWidth), ShooterHeight);
+		AddBlock(Location, FVector(1.f, 2.f, 4.f));
+	}
+}
+
+bool UWeaponBenchmarkCommandlet::WriteResults(const FString& Path) const
+{
+	TSharedRef<FJsonObject> Values = MakeShared<FJsonObject>();
+	for (const FWeaponBenchmarkMetric& Metric : Metrics)
+	{
+		Values->SetNumberField(Metric.Name, Metric.Value);
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("Suite"), TEXT("WeaponBenchmark"));
+	Root->SetStringField(TEXT("Cpu"), FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+	Root->SetObjectField(TEXT("Metrics"), Values);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	if (!FJsonSerializer::Serialize(Root, Writer) || !FFileHelper::SaveStringToFile(Json, *Path))
+	{
+		UE_LOG(LogTemp, Error, TEXT("WeaponBenchmark: can't write %s"), *Path);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("WeaponBenchmark: results written to %s"), *Path);
+	return true;
+}
+
+bool UWeaponBenchmarkCommandlet::CompareAgainstBaseline(const FString& Path, float InTolerance) const
+{
+	FString Json;
+	if (!FFileHelper::LoadFileToString(Json, *Path))
+	{
+		// Until a baseline is recorded on the reference machine there is nothing to gate against
+		UE_LOG(LogTemp, Warning, TEXT("WeaponBenchmark: no baseline at %s, skipping the gate, record one with -UpdateBaseline"), *Path);
+		return true;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	const TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Json);
+	const TSharedPtr<FJsonObject>* Baseline = nullptr;
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid() || !Root->TryGetObjectField(TEXT("Metrics"), Baseline))
+	{
+		UE_LOG(LogTemp, Error, TEXT("WeaponBenchmark: %s is not a benchmark baseline"), *Path);
+		return false;
+	}
+
+	bool bPassed = true;
+	for (const FWeaponBenchmarkMetric& Metric : Metrics)
+	{
+		double BaselineValue = 0.0;
+		if (!(*Baseline)->TryGetNumberField(Metric.Name, BaselineValue))
+		{
+			UE_LOG(LogTemp, Error, TEXT("WeaponBenchmark: %s has no baseline yet, record one with -UpdateBaseline"), *Metric.Name);
+			bPassed = false;
+			continue;
+		}
+
+		const double Change = BaselineValue > 0.0 ? Metric.Value / BaselineValue - 1.0 : 0.0;
+		if (Metric.bGated && Change > InTolerance)
+		{
+			UE_LOG(LogTemp, Error, TEXT("WeaponBenchmark: %s regressed by %.1f%% (%.3f, baseline %.3f, tolerance %.1f%%)"),
+				*Metric.Name, Change * 100.0, Metric.Value, BaselineValue, InTolerance * 100.f);
+			bPassed = false;
+		}
+		else
+		{
+			UE_LOG(LogTemp, Display, TEXT("WeaponBenchmark: %s %+.1f%%"), *Metric.Name, Change * 100.0);
+		}
+	}
+
+	// A renamed or dropped benchmark would otherwise quietly stop being checked
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : (*Baseline)->Values)
+	{
+		if (!Metrics.ContainsByPredicate([&Pair](const FWeaponBenchmarkMetric& Metric) { return Metric.Name == Pair.Key; }))
+		{
+			UE_LOG(LogTemp, Error, TEXT("WeaponBenchmark: %s is in the baseline but wasn't measured"), *Pair.Key);
+			bPassed = false;
+		}
+	}
+
+	return bPassed;
+}
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/WeaponFireScheduler.h"
+
+void FWeaponFireScheduler::Start(float Now, float Interval, float EarliestFirstShotTime)
+{
+	FirstShotTime = FMath::Max(Now, EarliestFirstShotTime);
+	ShotInterval = FMath::Max(Interval, KINDA_SMALL_NUMBER);
+	NumShotsFired = 0;
+	bIsFiring = true;
+}
+
+void FWeaponFireScheduler::Stop()
+{
+	bIsFiring = false;
+}
+
+void FWeaponFireScheduler::Advance(float Now, int32 MaxShots, TArray<float, TInlineAllocator<16>>& OutShotTimes)
+{
+	if (!bIsFiring)
+	{
+		return;
+	}
+
+	// Shot times are derived from the first one instead of being accumulated frame over frame, so no drift builds up
+	int32 NumShots = 0;
+	while (GetShotTime(NumShotsFired) <= Now && NumShots < MaxShots)
+	{
+		OutShotTimes.Add(GetShotTime(NumShotsFired));
+		++NumShotsFired;
+		++NumShots;
+	}
+}
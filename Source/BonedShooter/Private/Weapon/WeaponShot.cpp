@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/WeaponShot.h"
+
+#include "Math/RandomStream.h"
+#include "Math/VectorRegister.h"
+#include "Templates/TypeHash.h"
+
+uint32 FWeaponShotSendQueue::Add(const FWeaponShot& Shot, int32 MaxUnacked)
+{
+	if (Shots.Num() >= FMath::Max(MaxUnacked, 1))
+	{
+		Shots.RemoveAt(0, 1, false);
+		++FirstSequence;
+	}
+
+	const uint32 Sequence = FirstSequence + Shots.Num();
+	Shots.Add(Shot);
+	return Sequence;
+}
+
+bool FWeaponShotSendQueue::MakeBatch(int32 MaxShots, FWeaponShotBatch& OutBatch) const
+{
+	if (Shots.Num() == 0)
+	{
+		return false;
+	}
+
+	OutBatch.FirstSequence = FirstSequence;
+	OutBatch.Shots.Reset();
+	OutBatch.Shots.Append(Shots.GetData(), FMath::Min(Shots.Num(), MaxShots));
+	return true;
+}
+
+void FWeaponShotSendQueue::Acknowledge(uint32 LastProcessedSequence)
+{
+	if (LastProcessedSequence < FirstSequence)
+	{
+		return;
+	}
+
+	const int32 NumAcked = FMath::Min<int32>(LastProcessedSequence - FirstSequence + 1, Shots.Num());
+	Shots.RemoveAt(0, NumAcked, false);
+	FirstSequence += NumAcked;
+}
+
+bool FWeaponShotReceiveState::Accept(uint32 Sequence)
+{
+	// Shots repeated from a previous batch, or from a batch overtaken by a newer one, were already processed
+	if (Sequence <= LastProcessedSequence)
+	{
+		return false;
+	}
+
+	LastProcessedSequence = Sequence;
+	return true;
+}
+
+bool FWeaponShotSeedTracker::Accept(uint16 BurstSeed, uint16 ShotIndex, uint32 NumSkipped)
+{
+	// Bursts wrap around, the difference is taken modulo 2^16
+	const uint32 BurstStep = (uint16)(BurstSeed - LastBurstSeed);
+	if (BurstStep == 0)
+	{
+		// Same burst: the next index, or further by the shots skipped
+		if (ShotIndex <= LastShotIndex || (uint32)(ShotIndex - LastShotIndex - 1) > NumSkipped)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		// Later burst: every burst in between and every shot of this one before ShotIndex was skipped
+		if ((uint64)BurstStep - 1 + ShotIndex > NumSkipped)
+		{
+			return false;
+		}
+	}
+
+	LastBurstSeed = BurstSeed;
+	LastShotIndex = ShotIndex;
+	return true;
+}
+
+int32 FWeaponConeSampler::MakeSeed(int32 WeaponSeed, uint16 BurstSeed, uint16 ShotIndex)
+{
+	return (int32)HashCombine((uint32)WeaponSeed, ((uint32)BurstSeed << 16) | ShotIndex);
+}
+
+void FWeaponConeSampler::SampleDirections(const FVector& Axis, float HalfAngleDegrees, int32 Seed, TArrayView<FVector> OutDirections)
+{
+	const int32 NumDirections = FMath::Min(OutDirections.Num(), WEAPON_MAX_PELLETS);
+	if (NumDirections == 0)
+	{
+		return;
+	}
+
+	// Random numbers are drawn in pellet order so the volley only depends on Seed, the padding lanes stay at zero
+	const int32 NumPadded = Align(NumDirections, 4);
+	float PhiFractions[WEAPON_MAX_PELLETS] = {};
+	float ThetaFractions[WEAPON_MAX_PELLETS] = {};
+	FRandomStream Stream(Seed);
+	for (int32 Index = 0; Index < NumDirections; ++Index)
+	{
+		PhiFractions[Index] = Stream.GetFraction();
+		ThetaFractions[Index] = Stream.GetFraction();
+	}
+
+	// Uniform over the spherical cap: cos(theta) uniform in [cos(HalfAngle), 1], phi uniform around the axis
+	FVector AxisU, AxisV;
+	const FVector AxisW = Axis.GetSafeNormal();
+	AxisW.FindBestAxisVectors(AxisU, AxisV);
+
+	const VectorRegister One = VectorOne();
+	const VectorRegister TwoPi = VectorSetFloat1(2.f * PI);
+	const VectorRegister CapHeight = VectorSetFloat1(1.f - FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(HalfAngleDegrees, 0.f, 180.f))));
+	const VectorRegister MinSinSquared = VectorSetFloat1(SMALL_NUMBER);
+
+	float OutX[WEAPON_MAX_PELLETS];
+	float OutY[WEAPON_MAX_PELLETS];
+	float OutZ[WEAPON_MAX_PELLETS];
+	for (int32 Lane = 0; Lane < NumPadded; Lane += 4)
+	{
+		const VectorRegister Phi = VectorMultiply(VectorLoad(&PhiFractions[Lane]), TwoPi);
+		VectorRegister SinPhi, CosPhi;
+		VectorSinCos(&SinPhi, &CosPhi, &Phi);
+
+		const VectorRegister CosTheta = VectorSubtract(One, VectorMultiply(VectorLoad(&ThetaFractions[Lane]), CapHeight));
+		const VectorRegister SinSquared = VectorMax(VectorSubtract(One, VectorMultiply(CosTheta, CosTheta)), MinSinSquared);
+		const VectorRegister SinTheta = VectorMultiply(SinSquared, VectorReciprocalSqrtAccurate(SinSquared));
+
+		// Offsets from the axis in its own basis, then one multiply-add per world component
+		const VectorRegister OffsetU = VectorMultiply(SinTheta, CosPhi);
+		const VectorRegister OffsetV = VectorMultiply(SinTheta, SinPhi);
+
+		const auto Combine = [&](float W, float U, float V)
+		{
+			return VectorMultiplyAdd(CosTheta, VectorSetFloat1(W), VectorMultiplyAdd(OffsetU, VectorSetFloat1(U), VectorMultiply(OffsetV, VectorSetFloat1(V))));
+		};
+		VectorStore(Combine(AxisW.X, AxisU.X, AxisV.X), &OutX[Lane]);
+		VectorStore(Combine(AxisW.Y, AxisU.Y, AxisV.Y), &OutY[Lane]);
+		VectorStore(Combine(AxisW.Z, AxisU.Z, AxisV.Z), &OutZ[Lane]);
+	}
+
+	for (int32 Index = 0; Index < NumDirections; ++Index)
+	{
+		OutDirections[Index] = FVector(OutX[Index], OutY[Index], OutZ[Index]);
+	}
+}
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Weapon/WeaponSpreadModel.h"
+
+#include "Curves/RealCurve.h"
+#include "Engine/CurveTable.h"
+
+namespace WeaponSpreadModel
+{
+	static void ReadRow(const UCurveTable* SpecsTable, const TCHAR* RowName, float& InOutValue)
+	{
+		static const FString Context(TEXT("FWeaponSpreadSpecs::FromCurveTable"));
+		if (const FRealCurve* Curve = SpecsTable->FindCurve(RowName, Context, false))
+		{
+			InOutValue = Curve->Eval(0.f);
+		}
+	}
+}
+
+FWeaponSpreadSpecs FWeaponSpreadSpecs::FromCurveTable(const UCurveTable* SpecsTable, const FWeaponSpreadSpecs& Defaults)
+{
+	FWeaponSpreadSpecs Specs = Defaults;
+	if (SpecsTable)
+	{
+		WeaponSpreadModel::ReadRow(SpecsTable, TEXT("BaseSpread"), Specs.BaseSpread);
+		WeaponSpreadModel::ReadRow(SpecsTable, TEXT("MaxIdleSpread"), Specs.MaxIdleSpread);
+		WeaponSpreadModel::ReadRow(SpecsTable, TEXT("MaxWalkSpread"), Specs.MaxWalkSpread);
+		WeaponSpreadModel::ReadRow(SpecsTable, TEXT("SpreadSpeed"), Specs.SpreadSpeed);
+		WeaponSpreadModel::ReadRow(SpecsTable, TEXT("SpreadCooldown"), Specs.SpreadCooldown);
+	}
+	return Specs;
+}
+
+float FWeaponSpreadModel::GetHeat(float Now) const
+{
+	return FMath::Max(HeatAtLastShot - Specs.SpreadCooldown * FMath::Max(Now - LastShotTime, 0.f), 0.f);
+}
+
+float FWeaponSpreadModel::Evaluate(float Now, float Speed, bool bIsAiming) const
+{
+	const float MoveAlpha = Specs.WalkSpeedReference > 0.f ? FMath::Clamp(Speed / Specs.WalkSpeedReference, 0.f, 1.f) : 1.f;
+	const float MaxSpread = FMath::Lerp(Specs.MaxIdleSpread, Specs.MaxWalkSpread, MoveAlpha);
+	const float Spread = FMath::Clamp(Specs.BaseSpread + GetHeat(Now), Specs.BaseSpread, FMath::Max(MaxSpread, Specs.BaseSpread));
+	return bIsAiming ? Spread * Specs.AimingSpreadScale : Spread;
+}
+
+void FWeaponSpreadModel::RecordShot(float Now)
+{
+	// Heat above the highest cap would only delay the recovery without widening the spread
+	const float MaxHeat = FMath::Max(FMath::Max(Specs.MaxIdleSpread, Specs.MaxWalkSpread) - Specs.BaseSpread, 0.f);
+	// A shot reported late by a batch never moves the history back in time
+	Now = FMath::Max(Now, LastShotTime);
+	HeatAtLastShot = FMath::Min(GetHeat(Now) + Specs.SpreadSpeed, MaxHeat);
+	LastShotTime = Now;
+}
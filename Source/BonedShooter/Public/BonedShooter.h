@@ -3,3 +3,63 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+// --- Collision -- //
+// Trace channel of bullet sweeps, see DefaultEngine.ini. Pawn capsules ignore it, bullets hit the bodies of the mesh.
+#define COLLISION_PROJECTILE ECC_GameTraceChannel1
+
+// --- Random -- //
+/** 32 random bits. FMath::Rand only gives 15 of them on Windows, too few for seeds and ids that must not collide. */
+inline uint32 BonedShooterRand32()
+{
+	return ((uint32)FMath::Rand() << 30) ^ ((uint32)FMath::Rand() << 15) ^ (uint32)FMath::Rand();
+}
+
+// --- Profiling -- //
+// Hot paths of the game carry a cycle stat (stat BonedShooter), a CSV profiler timing (-csvCategories=BonedShooter)
+// and an Unreal Insights CPU event, events carry a counter in the stat group and in the CSV category.
+// Stats, the CSV profiler and trace are all disabled in Shipping, these macros then expand to nothing.
+
+DECLARE_STATS_GROUP(TEXT("BonedShooter"), STATGROUP_BonedShooter, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Weapon Fire"), STAT_BonedShooter_WeaponFire, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Server Fire Batch"), STAT_BonedShooter_ServerFireBatch, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Process Shot"), STAT_BonedShooter_ProcessShot, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Bullet Hit"), STAT_BonedShooter_BulletHit, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Bullet Movement"), STAT_BonedShooter_BulletMovement, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Resolve Damage"), STAT_BonedShooter_ResolveDamage, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Replicate Aim"), STAT_BonedShooter_ReplicateAim, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Weapon"), STAT_BonedShooter_SpawnWeapon, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Shots Fired"), STAT_BonedShooter_ShotsFired, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Shots Processed"), STAT_BonedShooter_ShotsProcessed, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Shots Rejected"), STAT_BonedShooter_ShotsRejected, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bullets Spawned"), STAT_BonedShooter_BulletsSpawned, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits"), STAT_BonedShooter_Hits, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Aim RPCs"), STAT_BonedShooter_AimRPCs, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Aim Updates Replicated"), STAT_BonedShooter_AimUpdates, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Aim Traces"), STAT_BonedShooter_AimTraces, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bullet Sweeps"), STAT_BonedShooter_BulletSweeps, STATGROUP_BonedShooter, BONEDSHOOTER_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(BONEDSHOOTER_API, BonedShooter);
+
+/**
+ * Times the rest of the scope as STAT_BonedShooter_<Name>, as the CSV stat <Name> and as the Insights event BonedShooter_<Name>.
+ * It declares the timers in the enclosing scope, so it can't be wrapped in do { } while (0): use it as a statement of
+ * a braced block, never as the body of an unbraced if or loop.
+ */
+#define BONEDSHOOTER_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_BonedShooter_##Name); \
+	CSV_SCOPED_TIMING_STAT(BonedShooter, Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(BonedShooter_##Name)
+
+/** Adds Amount to the per-frame counter STAT_BonedShooter_<Name> and to the CSV stat <Name> */
+#define BONEDSHOOTER_COUNT(Name, Amount) \
+	do \
+	{ \
+		INC_DWORD_STAT_BY(STAT_BonedShooter_##Name, Amount); \
+		CSV_CUSTOM_STAT(BonedShooter, Name, (int32)(Amount), ECsvCustomStatOp::Accumulate); \
+	} while (0)
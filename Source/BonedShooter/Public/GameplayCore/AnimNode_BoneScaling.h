@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoneControllers/AnimNode_SkeletalControlBase.h"
+#include "GameplayCore/ReplicatedBoneScale.h"
+#include "AnimNode_BoneScaling.generated.h"
+
+/**
+ * Scales the bones listed in the replicated bone scales of the owning ABonedShooterCharacter.
+ * Only works under a UBonedShooterAnimInstance, which hands the scales over to the animation threads.
+ */
+USTRUCT(BlueprintInternalUseOnly)
+struct BONEDSHOOTER_API FAnimNode_BoneScaling : public FAnimNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+	// FAnimNode_SkeletalControlBase interface
+	virtual void UpdateInternal(const FAnimationUpdateContext& Context) override;
+	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
+	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
+	// End of FAnimNode_SkeletalControlBase interface
+
+private:
+	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
+	void CacheCompactPoseBones(const FBoneContainer& RequiredBones);
+
+	/** Scales as of the last update, copied only when the character changes them */
+	TArray<FReplicatedBoneScale> BoneScales;
+	int32 BoneScalesRevision = INDEX_NONE;
+
+	/** Bones of BoneScales present at the current LOD, sorted by compact pose index as the base class requires */
+	struct FCachedBoneScale
+	{
+		FCompactPoseBoneIndex BoneIndex;
+		float Scale;
+		/** Entry of CachedBones of the closest ancestor that is scaled too, INDEX_NONE if there is none */
+		int32 ScaledAncestor;
+	};
+	TArray<FCachedBoneScale> CachedBones;
+	bool bCachedBonesDirty = true;
+};
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "AnimationBenchmarkSubsystem.generated.h"
+
+class ABonedShooterCharacter;
+
+/** Game thread timings of a benchmark run, in milliseconds. */
+struct FAnimationBenchmarkResult
+{
+	int32 NumCharacters = 0;
+	int32 NumFrames = 0;
+	double AverageGameThreadMs = 0.0;
+	double PeakGameThreadMs = 0.0;
+};
+
+/**
+ * Spawns a crowd of characters that keep moving and aiming, and measures the game thread time they cost.
+ * Meant to be run headless (-nullrhi) through BonedShooter.BenchmarkAnimation, once per character class to compare.
+ */
+UCLASS()
+class BONEDSHOOTER_API UAnimationBenchmarkSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	// End of FTickableGameObject interface
+
+	/** Spawns NumCharacters characters, lets them settle for WarmupFrames, then records NumFrames frames. */
+	void StartBenchmark(TSubclassOf<ABonedShooterCharacter> CharacterClass, int32 NumCharacters, int32 NumFrames, int32 WarmupFrames);
+
+	bool IsRunning() const { return Characters.Num() > 0; }
+
+private:
+	void FinishBenchmark();
+
+	UPROPERTY(Transient)
+	TArray<ABonedShooterCharacter*> Characters;
+
+	int32 FramesToSkip = 0;
+	int32 FramesToRecord = 0;
+	float ElapsedTime = 0.f;
+	FAnimationBenchmarkResult Result;
+};
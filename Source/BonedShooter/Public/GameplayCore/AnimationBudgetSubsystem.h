@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "AnimationBudgetSubsystem.generated.h"
+
+class ABonedShooterCharacter;
+
+/** How much animation work a remote character gets, from most to least. */
+UENUM(BlueprintType)
+enum class EAnimationBudgetTier : uint8
+{
+	/** Close and on screen: every frame, bones refreshed */
+	Full,
+	/** Mid range: lower tick rate with update rate optimizations */
+	Reduced,
+	/** Far away: lowest tick rate, physics bodies no longer follow the bones */
+	Low,
+	/** Not rendered recently: neither pose ticked nor bones refreshed until rendered again */
+	Offscreen,
+
+	Num UMETA(Hidden)
+};
+
+/** Number of registered characters in each tier. */
+USTRUCT(BlueprintType)
+struct BONEDSHOOTER_API FAnimationBudgetStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "AnimationBudget")
+	int32 NumFull = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AnimationBudget")
+	int32 NumReduced = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AnimationBudget")
+	int32 NumLow = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AnimationBudget")
+	int32 NumOffscreen = 0;
+
+	/** Characters pushed below the tier their distance earned to fit the budget */
+	UPROPERTY(BlueprintReadOnly, Category = "AnimationBudget")
+	int32 NumDemoted = 0;
+
+	/** Estimated animation cost of all registered characters this frame */
+	UPROPERTY(BlueprintReadOnly, Category = "AnimationBudget")
+	float EstimatedCostMs = 0.f;
+};
+
+/**
+ * Client-side animation budget for simulated proxies. Every frame, ranks the registered characters by significance
+ * (on screen first, then closest to the local view), gives each a tier from its distance, then demotes the least
+ * significant ones until the estimated animation cost fits AnimationBudgetMs.
+ */
+UCLASS(config=Game)
+class BONEDSHOOTER_API UAnimationBudgetSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	// End of FTickableGameObject interface
+
+	/** Puts the character's animation under the budget. Called by simulated proxies. */
+	void RegisterCharacter(ABonedShooterCharacter* Character);
+	void UnregisterCharacter(ABonedShooterCharacter* Character);
+
+	UFUNCTION(BlueprintCallable, Category = "AnimationBudget")
+	FAnimationBudgetStats GetBudgetStats() const { return Stats; }
+
+	void DumpStats() const;
+
+protected:
+	/** Animation time all remote characters may take per frame, in milliseconds */
+	UPROPERTY(Config)
+	float AnimationBudgetMs = 2.f;
+
+	/** Estimated cost of one character animated every frame with bones refreshed, in milliseconds */
+	UPROPERTY(Config)
+	float EstimatedFullRateCostMs = 0.08f;
+
+	/** Farthest distance of the Full and Reduced tiers, everything beyond is Low */
+	UPROPERTY(Config)
+	float FullTierDistance = 1500.f;
+
+	UPROPERTY(Config)
+	float ReducedTierDistance = 4000.f;
+
+	/** Seconds between two animation updates in the Reduced, Low and Offscreen tiers */
+	UPROPERTY(Config)
+	float ReducedTickInterval = 1.f / 30.f;
+
+	UPROPERTY(Config)
+	float LowTickInterval = 1.f / 15.f;
+
+	UPROPERTY(Config)
+	float OffscreenTickInterval = 0.25f;
+
+	/** A character not rendered for this long counts as off screen */
+	UPROPERTY(Config)
+	float OffscreenDelay = 0.2f;
+
+private:
+	struct FBudgetedCharacter
+	{
+		TWeakObjectPtr<ABonedShooterCharacter> Character;
+		EAnimationBudgetTier AppliedTier = EAnimationBudgetTier::Full;
+		EAnimationBudgetTier DesiredTier = EAnimationBudgetTier::Full;
+		float Significance = 0.f;
+	};
+
+	float GetTickInterval(EAnimationBudgetTier Tier) const;
+	float GetEstimatedCostMs(EAnimationBudgetTier Tier, float DeltaTime) const;
+	static void ApplyTier(ABonedShooterCharacter* Character, EAnimationBudgetTier Tier, float TickInterval);
+
+	TArray<FBudgetedCharacter> Characters;
+	FAnimationBudgetStats Stats;
+};
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "GameplayCore/ReplicatedBoneScale.h"
+#include "BonedShooterAnimInstance.generated.h"
+
+class UBonedShooterAnimInstance;
+
+/**
+ * Gathers the raw inputs of the character on the game thread, turns them into the values the anim graph reads on the
+ * animation worker thread.
+ */
+USTRUCT()
+struct BONEDSHOOTER_API FBonedShooterAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FBonedShooterAnimInstanceProxy() = default;
+	FBonedShooterAnimInstanceProxy(UAnimInstance* InAnimInstance) : FAnimInstanceProxy(InAnimInstance) {}
+
+	/** Bone scales of the character, read by FAnimNode_BoneScaling on the animation threads */
+	const TArray<FReplicatedBoneScale>& GetBoneScales() const { return BoneScales; }
+	int32 GetBoneScalesRevision() const { return BoneScalesRevision; }
+
+protected:
+	// FAnimInstanceProxy interface
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+	virtual void Update(float DeltaSeconds) override;
+	// End of FAnimInstanceProxy interface
+
+private:
+	/** Copied from the character, the only work left on the game thread */
+	FVector Velocity = FVector::ZeroVector;
+	FRotator ActorRotation = FRotator::ZeroRotator;
+	FRotator TargetAimRotation = FRotator::ZeroRotator;
+	bool bIsAiming = false;
+	bool bIsFalling = false;
+
+	TArray<FReplicatedBoneScale> BoneScales;
+	int32 BoneScalesRevision = INDEX_NONE;
+};
+
+/**
+ * Native base of the character anim blueprints. Aim offset and locomotion inputs are computed by the proxy off the game
+ * thread and exposed as plain members, so anim graph pins bind to them through the fast path.
+ */
+UCLASS()
+class BONEDSHOOTER_API UBonedShooterAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+	friend struct FBonedShooterAnimInstanceProxy;
+
+public:
+	/** Ground speed, in cm/s */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Locomotion")
+	float Speed = 0.f;
+
+	/** Angle between the velocity and the facing of the character, in [-180, 180] degrees */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Locomotion")
+	float Direction = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Locomotion")
+	bool bIsMoving = false;
+
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Locomotion")
+	bool bIsInAir = false;
+
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Aim")
+	bool bIsAiming = false;
+
+	/** Aim relative to the facing of the character, drives the aim offset */
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Aim")
+	float AimPitch = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Transient, Category = "Aim")
+	float AimYaw = 0.f;
+
+	/** Speed below which the character counts as standing still */
+	UPROPERTY(EditDefaultsOnly, Category = "Locomotion")
+	float MovingSpeedThreshold = 3.f;
+
+protected:
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override { return &Proxy; }
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override {}
+
+private:
+	UPROPERTY(Transient)
+	FBonedShooterAnimInstanceProxy Proxy;
+};
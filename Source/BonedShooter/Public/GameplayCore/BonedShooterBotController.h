@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Controller.h"
+#include "Math/RandomStream.h"
+#include "BonedShooterBotController.generated.h"
+
+class ABonedShooterCharacter;
+
+/**
+ * Scripted behaviour of a load-test bot: wanders, turns, aims and fires in bursts.
+ * Plays the character through the handlers its input bindings call, so a bot costs what a player costs on the server.
+ * Runs on a server-side bot controller as well as on the local player of a headless client.
+ */
+struct BONEDSHOOTER_API FBonedShooterBotBrain
+{
+	void Init(int32 Seed);
+
+	/** Steers the character of Controller for one frame */
+	void Tick(AController* Controller, ABonedShooterCharacter* Character, float DeltaTime);
+
+	/** Releases the trigger and stops aiming */
+	void Stop(ABonedShooterCharacter* Character);
+
+private:
+	FRandomStream Stream;
+	float Time = 0.f;
+	float NextDecisionTime = 0.f;
+	float TurnRate = 0.f;
+	float StrafeFrequency = 1.f;
+	bool bWantsAim = false;
+	bool bWantsFire = false;
+	bool bAiming = false;
+	bool bFiring = false;
+};
+
+/** Server-side controller of a load-test bot, see ULoadTestSubsystem. */
+UCLASS()
+class BONEDSHOOTER_API ABonedShooterBotController : public AController
+{
+	GENERATED_BODY()
+
+public:
+	ABonedShooterBotController();
+
+	virtual void PostInitializeComponents() override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Seeds the behaviour, bots with different seeds spread out and fire at different times */
+	void InitBrain(int32 Seed) { Brain.Init(Seed); }
+
+protected:
+	virtual void OnUnPossess() override;
+
+private:
+	FBonedShooterBotBrain Brain;
+};
@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "GameplayCore/QuantizedAimRotation.h"
+#include "GameplayCore/ReplicatedBoneScale.h"
 #include "BonedShooterCharacter.generated.h"
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnFired);
 
@@ -12,6 +14,9 @@ class ABonedShooterCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	/** Load-test bots play the character through its input handlers */
+	friend struct FBonedShooterBotBrain;
+
 	/** Camera boom positioning the camera behind the character */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class USpringArmComponent* CameraBoom;
@@ -19,8 +24,12 @@ class ABonedShooterCharacter : public ACharacter
 	/** Follow camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent* FollowCamera;
+
+	/** Camera aim shared by the weapon, the crosshair and the animation */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Aiming, meta = (AllowPrivateAccess = "true"))
+	class UAimingComponent* AimingComponent;
 public:
-	ABonedShooterCharacter();
+	ABonedShooterCharacter(const FObjectInitializer& ObjectInitializer);
 	
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
@@ -33,14 +42,36 @@ public:
 	UFUNCTION(BlueprintCallable, Category="BonedShooterCharacter")
 	class AWeaponActor* GetWeaponActor();
 	
-	UPROPERTY(Replicated, BlueprintReadWrite)
+	/** Spread of the current weapon, evaluated natively on every machine, see FWeaponSpreadModel */
+	UFUNCTION(BlueprintPure, Category="BonedShooterCharacter")
+	float GetCalculatedSpread() const;
+
+	/** Copy of GetCalculatedSpread, refreshed every tick for the Blueprints that still read it. Writing it has no effect on shots. */
+	UPROPERTY(BlueprintReadWrite, Category = "BonedShooterCharacter", meta = (DeprecatedProperty, DeprecationMessage = "Use GetCalculatedSpread or AWeaponActor::GetCurrentSpread instead."))
 	float CalculatedSpread;
 
 	UPROPERTY(BlueprintAssignable)
 	FOnFired OnFired;
+
+	UFUNCTION(BlueprintGetter, Category = "BonedShooterCharacter")
+	bool IsAiming() const { return bIsAiming; };
+
+	/** Aim used by the aim offset of remote players. Set locally from input and on the server from received moves. */
+	void SetTargetAimRotation(const FRotator& NewAimRotation);
+	const FRotator& GetTargetAimRotation() const { return TargetAimRotation; }
+
+	/** Scales a bone of the mesh, its children with it. Server only, a scale of 1 removes the entry. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "BonedShooterCharacter|BoneScaling")
+	void SetBoneScale(FName BoneName, float Scale);
+
+	const TArray<FReplicatedBoneScale>& GetBoneScales() const { return BoneScales; }
+
+	/** Bumped whenever BoneScales changes, lets readers skip copying it */
+	int32 GetBoneScalesRevision() const { return BoneScalesRevision; }
 protected:
 	
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Tick(float DeltaSeconds) override;
 	// --- Base movement -- //
 	
@@ -86,14 +117,24 @@ protected:
 	UFUNCTION(Server, Reliable)
 	void ServerStopAim();
 	
-	UFUNCTION(BlueprintGetter, Category = "BonedShooterCharacter")
-    bool IsAiming() { return bIsAiming; };
-
 	void StartFire();
 	void EndFire();
 
-	UPROPERTY(Replicated, BlueprintReadOnly)
+	/** Aim driving the aim offset. Smoothed towards ReplicatedAimRotation on simulated proxies. */
+	UPROPERTY(BlueprintReadOnly)
 	FRotator TargetAimRotation;
+
+	/** Aim sent to simulated proxies, only updated when it moved by more than AimReplicationThreshold */
+	UPROPERTY(Replicated)
+	FQuantizedAimRotation ReplicatedAimRotation;
+
+	/** Changes of aim smaller than this, in degrees, are not sent to simulated proxies */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Aim")
+	float AimReplicationThreshold;
+
+	/** How fast simulated proxies catch up with the last received aim */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Aim")
+	float AimInterpolationSpeed;
 	
 	UPROPERTY(Replicated)
 	class AWeaponActor* CurrentWeapon;
@@ -107,14 +148,29 @@ protected:
 
 
 private:
-	UPROPERTY(Replicated, BlueprintGetter="IsAiming")
+	/** Bones scaled away from the reference pose, applied by FAnimNode_BoneScaling */
+	UPROPERTY(ReplicatedUsing=OnRep_BoneScales)
+	TArray<FReplicatedBoneScale> BoneScales;
+
+	int32 BoneScalesRevision = 0;
+
+	UFUNCTION()
+	void OnRep_BoneScales();
+
+	/** Scales the physics bodies like the animation scales the bones, so hits land on what is drawn */
+	void ApplyBoneScalesToPhysics();
+
+	UPROPERTY(ReplicatedUsing=OnRep_IsAiming, BlueprintGetter="IsAiming")
 	bool bIsAiming;
- 
+
+	/** Only write site of bIsAiming, marks it dirty for replication */
+	void SetIsAiming(bool bNewIsAiming);
+
 	UFUNCTION()
-	void ReplicateAimOffset();
+	void OnRep_IsAiming();
 
-	UFUNCTION(Server, Reliable)
-	void SetRemoteControlRotation();
+	/** The aim trace only runs for the local player, and only while aiming */
+	void UpdateAimingComponentActive();
  
 protected:
 	// APawn interface
@@ -126,6 +182,8 @@ public:
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns AimingComponent subobject **/
+	FORCEINLINE class UAimingComponent* GetAimingComponent() const { return AimingComponent; }
 	/** @return	Pawn's eye location */
 	virtual FVector GetPawnViewLocation() const override;
 
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "BonedShooterCharacterMovementComponent.generated.h"
+
+/**
+ * Character movement that also delivers the aim of remote players.
+ * Every move a client sends already carries its control rotation, quantized to 16 bits per axis, at movement rate.
+ * The server takes the aim from there instead of from a separate RPC per input event.
+ */
+UCLASS()
+class BONEDSHOOTER_API UBonedShooterCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void ServerMove_PerformMovement(const FCharacterNetworkMoveData& MoveData) override;
+};
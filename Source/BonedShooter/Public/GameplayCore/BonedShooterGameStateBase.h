@@ -13,5 +13,14 @@ UCLASS()
 class BONEDSHOOTER_API ABonedShooterGameStateBase : public AGameStateBase
 {
 	GENERATED_BODY()
-	
+
+public:
+	virtual void PostInitializeComponents() override;
+
+	/** Random per match, picked by the server. Tells the shot telemetry logs of different matches apart. */
+	uint32 GetSessionId() const { return (uint32)SessionId; }
+
+private:
+	UPROPERTY(Replicated)
+	int32 SessionId = 0;
 };
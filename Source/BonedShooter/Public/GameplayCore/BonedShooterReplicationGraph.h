@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "BonedShooterReplicationGraph.generated.h"
+
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_GridSpatialization2D;
+
+/** How the replication graph routes the actors of a class. */
+enum class EBonedShooterClassRepPolicy : uint8
+{
+	NotRouted,
+	/** Relevant to every connection, e.g. the game state */
+	RelevantAllConnections,
+	/** Placed in the spatial grid and moved every frame, e.g. characters and bullets */
+	Spatialize_Dynamic,
+	/** Placed in the spatial grid once, e.g. level actors that never move */
+	Spatialize_Static,
+	/** In the grid as static while dormant, as dynamic while awake */
+	Spatialize_Dormancy,
+};
+
+/**
+ * Replicates to each connection its own player controller, pawn, player state and weapon, whatever the grid says.
+ */
+UCLASS()
+class BONEDSHOOTER_API UBonedShooterReplicationGraphNode_AlwaysRelevant_ForConnection : public UReplicationGraphNode_AlwaysRelevant_ForConnection
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+};
+
+/**
+ * Replication graph of BonedShooter. Characters and bullets live in a 2D spatial grid, so a connection only considers
+ * the cells around its viewer instead of every actor. Weapons follow their character as dependent actors and are always
+ * relevant to their owner. Plugged in through ReplicationDriverClassName in DefaultEngine.ini.
+ *
+ * Every replicated class is replicated once every ReplicationPeriodFrame server frames, derived from its
+ * NetUpdateFrequency when the graph starts. Adaptive net update frequency and MinNetUpdateFrequency only drive the
+ * default net driver path, they have no effect under the graph.
+ */
+UCLASS(transient, config=Engine)
+class BONEDSHOOTER_API UBonedShooterReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	// UReplicationGraph interface
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+	// End of UReplicationGraph interface
+
+	/** Logs the average time spent replicating per frame since the last dump, with the number of connections. */
+	void DumpReplicationTime();
+
+	/** Time spent in the last ServerReplicateActors, for the load test */
+	double GetLastReplicationSeconds() const { return LastReplicationSeconds; }
+
+protected:
+	/** Side of a grid cell, in cm */
+	UPROPERTY(Config)
+	float GridCellSize = 10000.f;
+
+	/** Lowest corner of the map, the grid starts there */
+	UPROPERTY(Config)
+	FVector2D GridSpatialBias = FVector2D(-200000.f, -200000.f);
+
+	/** Characters and bullets farther than this from a viewer are not replicated to it */
+	UPROPERTY(Config)
+	float CharacterCullDistance = 15000.f;
+
+	UPROPERTY(Config)
+	float BulletCullDistance = 5000.f;
+
+	/** Other players' states only need to be fresh enough for the scoreboard */
+	UPROPERTY(Config)
+	int32 PlayerStateReplicationPeriodFrame = 10;
+
+private:
+	EBonedShooterClassRepPolicy GetClassPolicy(UClass* Class);
+
+	/** Replication period and cull distance of Class from its defaults, the cull distance only matters when spatialized */
+	void InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool bSpatialize) const;
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	TClassMap<EBonedShooterClassRepPolicy> ClassRepPolicies;
+
+	double ReplicationSeconds = 0.0;
+	double LastReplicationSeconds = 0.0;
+	int32 ReplicationFrames = 0;
+};
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "LagCompensationSubsystem.generated.h"
+
+class ABonedShooterCharacter;
+class UNetConnection;
+
+/** Upper bound of bones tracked per character, lets rewound poses live on the stack */
+#define LAG_COMPENSATION_MAX_BONES 16
+
+/** Capsule and key bones of a character at a given point in time. */
+struct FLagCompensatedPose
+{
+	FVector CapsuleLocation = FVector::ZeroVector;
+	float CapsuleRadius = 0.f;
+	float CapsuleHalfHeight = 0.f;
+	TArray<FTransform, TInlineAllocator<LAG_COMPENSATION_MAX_BONES>> BoneTransforms;
+};
+
+/** Fixed-size ring buffer of the poses of one character, laid out contiguously per field. */
+struct FLagCompensationHistory
+{
+	TWeakObjectPtr<ABonedShooterCharacter> Character;
+
+	/** Mesh bone indices resolved once at registration, in TrackedBones order */
+	TArray<int32, TInlineAllocator<LAG_COMPENSATION_MAX_BONES>> BoneIndices;
+
+	float CapsuleRadius = 0.f;
+	float CapsuleHalfHeight = 0.f;
+
+	TArray<float> Times;
+	TArray<FVector> CapsuleLocations;
+	/** Capacity * BoneIndices.Num() entries, bones of a frame are adjacent */
+	TArray<FTransform> BoneTransforms;
+
+	/** Next slot to write */
+	int32 Head = 0;
+	/** Valid frames, up to capacity */
+	int32 Count = 0;
+
+	int32 GetCapacity() const { return Times.Num(); }
+
+	/** Physical slot of the LogicalIndex-th oldest frame */
+	int32 ToSlot(int32 LogicalIndex) const { return (Head - Count + LogicalIndex + GetCapacity()) % GetCapacity(); }
+};
+
+/**
+ * Server-side history of character hitboxes, recorded every tick, used to look at the world the way a client saw it
+ * when it pulled the trigger.
+ */
+UCLASS(config=Game)
+class BONEDSHOOTER_API ULagCompensationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	// End of FTickableGameObject interface
+
+	/** Starts recording the character. Called by the character on the server. */
+	void RegisterCharacter(ABonedShooterCharacter* Character);
+	void UnregisterCharacter(ABonedShooterCharacter* Character);
+
+	/** Interpolated pose of the character at Timestamp (server world time). Does not allocate. */
+	bool GetRewoundPose(const ABonedShooterCharacter* Character, float Timestamp, FLagCompensatedPose& OutPose) const;
+
+	/**
+	 * Replays the client's aim ray Start -> End against the characters as they were at Timestamp.
+	 * When it hits one that no static geometry hides, returns the same point of its body in present time,
+	 * when static geometry blocks the ray, returns the blocking point, otherwise returns End unchanged.
+	 */
+	FVector ResolveShotDestination(const FVector& Start, const FVector& End, float Timestamp, const AActor* Shooter) const;
+
+	/** Current time on the clock histories are recorded with, to be sent by clients along with their shots. */
+	static float GetLagCompensationTime(const UWorld* World);
+
+	/**
+	 * Time of the world a client was looking at when it fired at ClientFireTime, what shots are rewound to.
+	 * ClientFireTime is on a clock that is as late as the replicated state, remote characters are smoothed on top of that.
+	 * Null Connection for the shots of the server's own players and bots, which see the present.
+	 */
+	float GetClientViewTime(float ClientFireTime, const UNetConnection* Connection) const;
+
+protected:
+	/** Frames kept per character, fixed at registration */
+	UPROPERTY(Config)
+	int32 HistoryCapacity = 64;
+
+	/** Shots claiming to be older than this are resolved at the oldest allowed time */
+	UPROPERTY(Config)
+	float MaxRewindTime = 0.5f;
+
+	/**
+	 * How far behind the replicated state clients draw remote characters, the movement component's
+	 * NetworkSimulatedSmoothLocationTime
+	 */
+	UPROPERTY(Config)
+	float InterpolationDelay = 0.1f;
+
+	/** Bones recorded next to the capsule, each used as a hit sphere */
+	UPROPERTY(Config)
+	TArray<FName> TrackedBones;
+
+	UPROPERTY(Config)
+	float BoneHitRadius = 15.f;
+
+private:
+	void RecordFrame(FLagCompensationHistory& History, float Now);
+	void RemoveHistoryAt(int32 Index);
+	const FLagCompensationHistory* FindHistory(const ABonedShooterCharacter* Character) const;
+	static void SamplePose(const FLagCompensationHistory& History, int32 LogicalIndex, float Alpha, FLagCompensatedPose& OutPose);
+	bool TraceAgainstPose(const FLagCompensatedPose& Pose, const FVector& Start, const FVector& End, int32& OutBone, FVector& OutPoint) const;
+
+	TArray<FLagCompensationHistory> Histories;
+	TMap<const ABonedShooterCharacter*, int32> HistoryIndexByCharacter;
+};
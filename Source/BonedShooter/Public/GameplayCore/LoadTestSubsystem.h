@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayCore/BonedShooterBotController.h"
+#include "HAL/PlatformProcess.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "LoadTestSubsystem.generated.h"
+
+/** Per-frame measurements of a load-test run, on the server. */
+struct FLoadTestSample
+{
+	float FrameMs = 0.f;
+	float GameThreadMs = 0.f;
+	/** From the start of the world tick to the end of actor and tickable ticks, network receive included */
+	float WorldTickMs = 0.f;
+	/** Replication and network send */
+	float NetFlushMs = 0.f;
+	/** Part of NetFlushMs spent in the replication graph, 0 without it */
+	float ReplicationMs = 0.f;
+	int32 BulletsAlive = 0;
+};
+
+/**
+ * Headless dedicated server load test. Spawns bots that play characters through their input handlers, optionally
+ * launches headless client processes that do the same for their local player, records the server frame and network
+ * costs, then appends one row per run to a CSV file.
+ *
+ * Server, from the command line (exits when the run is over):
+ *   UE4Editor-Cmd BonedShooter.uproject /Game/BonedShooter/Maps/ThirdPersonExampleMap -server -nullrhi -log
+ *     -LoadTestBots=64 -LoadTestDuration=120 [-LoadTestClients=4] [-LoadTestCsv=Path]
+ * or from the console of a running server: BonedShooter.StartLoadTest [NumBots] [Seconds] [NumClients]
+ * A list of bot counts, e.g. -LoadTestBots=8,16,32,64, runs once per count and writes one row each, which gives the
+ * replication graph time against the player count.
+ * Headless clients are started with -LoadTestClient, their local player is then driven by a bot brain.
+ *
+ * The report says whether push model replication was on. Comparing NetFlushMsAvg of two runs with the same bots, one of
+ * them with -dpcvars=net.IsPushModelEnabled=0, gives what the push model saves at that connection count.
+ */
+UCLASS(config=Game)
+class BONEDSHOOTER_API ULoadTestSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	// End of FTickableGameObject interface
+
+	/** Server: spawns NumBots bots and NumClients headless clients, then records for Seconds after the warmup. */
+	void StartLoadTest(int32 NumBots, float Seconds, int32 NumClients);
+
+	/** Runs StartLoadTest once per entry of BotCounts, one after the other. */
+	void StartLoadTestSeries(const TArray<int32>& BotCounts, float Seconds, int32 NumClients);
+
+	/** Bot counts of a comma separated list, e.g. "8,16,32" */
+	static TArray<int32> ParseBotCounts(const FString& List);
+
+	bool IsRunning() const { return bRunning; }
+
+	/** Server: counts a ServerFireBatch received from a client, the net driver only counts the RPCs it sends */
+	void CountIncomingFireBatch();
+
+protected:
+	/** Seconds after the start that are not recorded, while bots spread out and clients connect */
+	UPROPERTY(Config)
+	float WarmupSeconds = 5.f;
+
+	/** Report written when -LoadTestCsv isn't given, relative to the project's Saved directory */
+	UPROPERTY(Config)
+	FString DefaultCsvFile = TEXT("LoadTest/LoadTest.csv");
+
+	/** Extra arguments of the headless client processes */
+	UPROPERTY(Config)
+	FString ClientCommandLine = TEXT("-nullrhi -nosound -unattended -nosplash -log");
+
+private:
+	void SpawnBots(int32 NumBots);
+	void LaunchClients(int32 NumClients);
+	void FinishLoadTest();
+	void WriteReport() const;
+
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	void OnPostTickFlush();
+
+	int32 CountBulletsAlive() const;
+
+	bool bRunning = false;
+	float ElapsedTime = 0.f;
+	float RecordSeconds = 0.f;
+	FString CsvPath;
+
+	/** Run requested on the command line, started once the world has begun play, then the process exits */
+	bool bStartFromCommandLinePending = false;
+	bool bExitWhenDone = false;
+	TArray<int32> CommandLineBots;
+	float CommandLineSeconds = 0.f;
+	int32 CommandLineClients = 0;
+
+	UPROPERTY(Transient)
+	TArray<ABonedShooterBotController*> Bots;
+
+	TArray<FProcHandle> ClientProcesses;
+
+	// --- Frame breakdown, stamped by the world delegates -- //
+	double WorldTickStartSeconds = 0.0;
+	double PostActorTickSeconds = 0.0;
+
+	// --- Recording -- //
+	TArray<FLoadTestSample> Samples;
+	uint32 FirstRecordedRPCs = 0;
+	uint32 LastRecordedRPCs = 0;
+	uint32 RecordedFireBatches = 0;
+	float RecordedSeconds = 0.f;
+	double OutBytesPerConnectionSum = 0.0;
+	int32 OutBytesPerConnectionCount = 0;
+	int32 PeakOutBytesPerConnection = 0;
+	int32 PeakConnections = 0;
+	int32 NumBotsRequested = 0;
+	int32 NumClientsRequested = 0;
+
+	/** Bot counts of the series still to run after this one */
+	TArray<int32> PendingBotCounts;
+
+	/** Headless client: the local player is played by this brain */
+	bool bDriveLocalPlayer = false;
+	FBonedShooterBotBrain LocalPlayerBrain;
+
+	FDelegateHandle WorldTickStartHandle;
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle PostTickFlushHandle;
+};
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "QuantizedAimRotation.generated.h"
+
+/**
+ * Aim of a character as sent to simulated proxies: pitch and yaw only, quantized to a configurable number of bits.
+ * The bit depth travels with the value, so server and clients never have to agree on it.
+ */
+USTRUCT(BlueprintType)
+struct BONEDSHOOTER_API FQuantizedAimRotation
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Aim")
+	float Pitch = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Aim")
+	float Yaw = 0.f;
+
+	FQuantizedAimRotation() = default;
+	explicit FQuantizedAimRotation(const FRotator& Rotation)
+		: Pitch(Rotation.Pitch)
+		, Yaw(Rotation.Yaw)
+	{
+	}
+
+	FRotator ToRotator() const { return FRotator(Pitch, Yaw, 0.f); }
+
+	/** True when the two aims differ by more than ToleranceDegrees on either axis. */
+	bool DiffersFrom(const FQuantizedAimRotation& Other, float ToleranceDegrees) const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FQuantizedAimRotation> : public TStructOpsTypeTraitsBase2<FQuantizedAimRotation>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
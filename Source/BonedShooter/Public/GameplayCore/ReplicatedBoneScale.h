@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicatedBoneScale.generated.h"
+
+/** Scale of one bone of a character mesh, four bytes on the wire. */
+USTRUCT(BlueprintType)
+struct BONEDSHOOTER_API FReplicatedBoneScale
+{
+	GENERATED_BODY()
+
+	/** Index of the bone in the reference skeleton of the mesh */
+	UPROPERTY()
+	uint16 BoneIndex = 0;
+
+	/** Uniform scale, in hundredths */
+	UPROPERTY()
+	uint16 QuantizedScale = 100;
+
+	float GetScale() const { return QuantizedScale / 100.f; }
+	void SetScale(float Scale) { QuantizedScale = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(Scale * 100.f), 0, static_cast<int32>(MAX_uint16))); }
+};
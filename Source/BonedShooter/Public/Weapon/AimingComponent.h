@@ -3,10 +3,44 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
 #include "Components/ActorComponent.h"
 #include "AimingComponent.generated.h"
 
+/** Where the owner is looking and what it is looking at. */
+USTRUCT(BlueprintType)
+struct BONEDSHOOTER_API FAimSolution
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Aim")
+	FVector ViewLocation = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Aim")
+	FRotator ViewRotation = FRotator::ZeroRotator;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Aim")
+	bool bHit = false;
+
+	/** Blocking hit of the camera trace, or the end of the trace when nothing was hit */
+	UPROPERTY(BlueprintReadOnly, Category = "Aim")
+	FVector HitLocation = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Aim")
+	FVector HitNormal = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Aim")
+	AActor* HitActor = nullptr;
+
+	/** Distance from the view location to HitLocation */
+	UPROPERTY(BlueprintReadOnly, Category = "Aim")
+	float HitDistance = 0.f;
+};
 
+/**
+ * Owns the aim of the locally controlled character: traces from the camera at most once per frame and shares the
+ * result with the weapon, the crosshair and the animation. Only ticks while the character aims.
+ */
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class BONEDSHOOTER_API UAimingComponent : public UActorComponent
 {
@@ -16,6 +50,29 @@ public:
 	// Sets default values for this component's properties
 	UAimingComponent();
 
+	/** Aim solution of the current frame, traced on the first call of the frame. Game thread only. */
+	UFUNCTION(BlueprintCallable, Category = "Aim")
+	const FAimSolution& GetAimSolution();
+
+	/** Whether GetAimSolution won't need to trace again this frame */
+	bool HasAimSolutionThisFrame() const { return SolutionFrame == GFrameCounter; }
+
+	/**
+	 * Aim solution as of this component's last tick, safe to read from animation worker threads:
+	 * it is only written by the tick, which the owner's mesh waits for.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Aim", meta = (BlueprintThreadSafe))
+	const FAimSolution& GetLastTickedAimSolution() const { return TickedSolution; }
+
+	/** Turns the per-frame aim trace on while the owner aims, off otherwise */
+	void SetAimingActive(bool bActive);
+
+	UPROPERTY(EditDefaultsOnly, Category = "Aim")
+	float AimTraceDistance;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Aim")
+	TEnumAsByte<ECollisionChannel> AimTraceChannel;
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
@@ -24,5 +81,17 @@ public:
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
-		
+private:
+	void UpdateAimSolution();
+
+	UPROPERTY(Transient)
+	FAimSolution Solution;
+	uint64 SolutionFrame = MAX_uint64;
+
+	UPROPERTY(Transient)
+	FAimSolution TickedSolution;
+
+	/** Built once per owner and weapon instead of once per trace */
+	FCollisionQueryParams QueryParams;
+	TWeakObjectPtr<AActor> QueryParamsWeapon;
 };
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/MovementComponent.h"
+#include "BallisticMovementComponent.generated.h"
+
+/** Closed-form motion of a point under constant gravity and a drag proportional to its velocity. */
+struct BONEDSHOOTER_API FBallisticTrajectory
+{
+	/**
+	 * Moves Position and Velocity DeltaTime ahead. Exact for any DeltaTime, so the path doesn't depend on the frame rate.
+	 * @param Drag	Fraction of the velocity lost per second, 0 for a plain parabola
+	 */
+	static void Advance(FVector& Position, FVector& Velocity, const FVector& Gravity, float Drag, float DeltaTime);
+};
+
+/**
+ * Bullet mover: follows an analytic ballistic trajectory and sweeps the updated component along it in straight
+ * segments no longer than MaxSegmentLength, so fast bullets can't tunnel and slow ones sweep once per frame.
+ * Only scene queries, the updated component can be query-only. Blocking hits are dispatched to the owner
+ * like a swept move would, and stop the bullet.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class BONEDSHOOTER_API UBallisticMovementComponent : public UMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UBallisticMovementComponent();
+
+	virtual void InitializeComponent() override;
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Starts the flight along Direction at InitialSpeed */
+	void Launch(const FVector& Direction);
+
+	/** Speed along the launch direction, in uu/s */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ballistics")
+	float InitialSpeed;
+
+	/** Multiplies the world gravity */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ballistics")
+	float GravityScale;
+
+	/** Fraction of the velocity lost per second to air resistance */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ballistics", meta = (ClampMin = "0.0"))
+	float Drag;
+
+	/** Longest straight sweep along the curve. Shorter follows the drop more closely, at one sweep per segment. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ballistics", meta = (ClampMin = "1.0"))
+	float MaxSegmentLength;
+
+	/** Upper bound of sweeps per tick, segments get longer past it */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ballistics", meta = (ClampMin = "1"))
+	int32 MaxSegmentsPerTick;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ballistics")
+	bool bRotationFollowsVelocity;
+
+	/** Channel of the sweeps, what blocks on it stops the bullet */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ballistics")
+	TEnumAsByte<ECollisionChannel> SweepChannel;
+
+	/** World gravity scaled by GravityScale */
+	virtual float GetGravityZ() const override;
+
+private:
+	/** Sweeps the updated component from Start to End, true on a blocking hit */
+	bool SweepSegment(const FVector& Start, const FVector& End, FHitResult& OutHit) const;
+};
@@ -4,8 +4,26 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Engine/NetSerialization.h"
 #include "Bullet.generated.h"
 
+/** Where from and along what the server last launched a bullet. Pooled bullets are reused, clients re-launch on every change. */
+USTRUCT()
+struct FBulletLaunchState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Origin;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal Direction;
+
+	/** Bumped on every launch, so a reuse from the same muzzle in the same direction still replicates */
+	UPROPERTY()
+	uint8 LaunchCount = 0;
+};
+
 UCLASS()
 class BONEDSHOOTER_API ABullet : public AActor
 {
@@ -29,13 +47,68 @@ public:
 	UPROPERTY(VisibleDefaultsOnly, Category = Projectile)
 	UStaticMeshComponent* ProjectileMeshComponent;
 	
-	// Projectile movement component.
+	// Ballistic movement component.
 	UPROPERTY(VisibleAnywhere, Category = Movement)
-	class UProjectileMovementComponent* ProjectileMovementComponent;
+	class UBallisticMovementComponent* BallisticMovementComponent;
+
+	/** Mask filter of bullet bodies, ignored by bullet sweeps so the pellets of a volley don't stop each other */
+	static constexpr FMaskFilter BulletMaskFilter = 1 << 0;
 
 	// Function that initializes the projectile's velocity in the shoot direction.
 	void LaunchInDirection(const FVector& ShootDirection);
 
+	/**
+	 * Queues the damage of a bullet fired by Weapon for the end-of-frame damage pass, see UDamageQueueSubsystem,
+	 * and records the hit in the shot telemetry. Shared by the actor and the batched projectile backends.
+	 */
+	static void QueueHitDamage(const FHitResult& Hit, const FVector& ShotDirection, const class AWeaponActor* Weapon, APawn* DamageInstigator, AActor* DamageCauser, uint32 ShotSequence);
+
+	/** Sequence of the shot that fired this bullet, set by the weapon on the server */
+	uint32 ShotSequence = 0;
+
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComponent, FVector NormalImpulse, const FHitResult& Hit);
+
+	// --- Pooling -- //
+
+	/** Set by UProjectilePoolSubsystem on bullets it owns, those are parked instead of destroyed */
+	bool bIsPooled = false;
+
+	/** Parked in the pool, between OnReturnedToPool and the next OnAcquiredFromPool */
+	bool IsInPool() const { return bInPool; }
+
+	/**
+	 * Cosmetic bullets are client-side visuals of a shot simulated by UProjectileSimulationSubsystem:
+	 * they are not replicated and stop on hit without dealing damage.
+	 */
+	void SetCosmeticOnly(bool bInCosmeticOnly);
+
+	bool IsCosmeticOnly() const { return bCosmeticOnly; }
+
+	/** Places the bullet at SpawnTransform and makes it visible, collidable and movable again. */
+	void OnAcquiredFromPool(const FTransform& SpawnTransform, AActor* NewOwner, APawn* NewInstigator);
+
+	/** Hides the bullet and turns off everything that costs time while it waits in the pool. */
+	void OnReturnedToPool();
+
+	/** Ends the bullet's flight: back to the pool when pooled, destroyed otherwise. */
+	void FinishFlight();
+
+	virtual void LifeSpanExpired() override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+private:
+	/** Shows the bullet at SpawnTransform and restarts its movement and life span, on the server and on clients */
+	void BeginFlight(const FTransform& SpawnTransform);
+
+	/** Set by the server on every launch, clients launch their copy from it */
+	UPROPERTY(ReplicatedUsing=OnRep_LaunchState)
+	FBulletLaunchState LaunchState;
+
+	UFUNCTION()
+	void OnRep_LaunchState();
+
+	bool bCosmeticOnly = false;
+	bool bInPool = false;
 };
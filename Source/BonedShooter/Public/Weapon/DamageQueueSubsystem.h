@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "DamageQueueSubsystem.generated.h"
+
+class AWeaponActor;
+class USkeleton;
+
+/** Damage multiplier of a bone, inherited by its children that don't have their own entry. */
+USTRUCT()
+struct FBoneHitZone
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	FName BoneName;
+
+	UPROPERTY(Config)
+	float DamageMultiplier = 1.f;
+};
+
+/** Damage multiplier of a physical surface, applied on top of the bone one. */
+USTRUCT()
+struct FSurfaceHitZone
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	TEnumAsByte<EPhysicalSurface> SurfaceType = SurfaceType_Default;
+
+	UPROPERTY(Config)
+	float DamageMultiplier = 1.f;
+};
+
+/**
+ * Server-side damage pipeline. Bullet hits are queued as they happen during the frame, then resolved together once
+ * every actor has ticked, with the damage of the weapon that fired them scaled by the hit zone.
+ * Hit zones are compiled once per skeleton into a table indexed by bone, and once into a table indexed by surface type.
+ */
+UCLASS(config=Game)
+class BONEDSHOOTER_API UDamageQueueSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * Queues the damage of a bullet fired by Weapon for the end of the frame.
+	 * Dropped when the weapon is gone, there is nothing left to take the damage from.
+	 */
+	void QueueHit(const FHitResult& Hit, const FVector& ShotDirection, const AWeaponActor* Weapon, APawn* DamageInstigator, AActor* DamageCauser);
+
+	/** Multiplier of the zone Hit landed on, 1 when it is not on a zone */
+	float GetHitZoneMultiplier(const FHitResult& Hit);
+
+	UFUNCTION(BlueprintCallable, Category = "DamageQueue")
+	int32 GetNumQueuedHits() const { return QueuedHits.Num(); }
+
+protected:
+	UPROPERTY(Config)
+	TArray<FBoneHitZone> BoneHitZones;
+
+	UPROPERTY(Config)
+	TArray<FSurfaceHitZone> SurfaceHitZones;
+
+private:
+	struct FQueuedHit
+	{
+		TWeakObjectPtr<AActor> Victim;
+		FHitResult Hit;
+		FVector ShotDirection;
+		float BaseDamage;
+		TSubclassOf<UDamageType> DamageTypeClass;
+		TWeakObjectPtr<AController> InstigatorController;
+		TWeakObjectPtr<AActor> DamageCauser;
+	};
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	void ResolveQueuedHits();
+
+	/** Bone multipliers of Skeleton by skeleton bone index, built on first use */
+	const TArray<float>& GetBoneMultipliers(const USkeleton* Skeleton);
+
+	TArray<FQueuedHit> QueuedHits;
+	/** Hits being resolved, damage handlers may queue new ones meanwhile */
+	TArray<FQueuedHit> ResolvingHits;
+
+	TMap<TObjectKey<USkeleton>, TArray<float>> BoneMultipliersBySkeleton;
+	float SurfaceMultipliers[SurfaceType_Max];
+
+	FDelegateHandle PostActorTickHandle;
+};
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FireValidationSubsystem.generated.h"
+
+class UNetConnection;
+
+/** Why the server dropped a shot of a client instead of simulating it. */
+enum class EShotRejection : uint8
+{
+	None,
+	/** Faster than the weapon's fire rate allows, see AWeaponActor::ShotBurstAllowance */
+	RateLimited,
+	/** Fired from too far from where the server has the weapon's muzzle */
+	ImplausibleOrigin,
+	/** Burst seed or shot index not following the previous shot, see FWeaponShotSeedTracker */
+	InvalidSeed
+};
+
+/** Shots of one client connection, as the server judged them. */
+struct FFireRejectionStats
+{
+	int32 ShotsAccepted = 0;
+	int32 ShotsRateLimited = 0;
+	int32 ShotsImplausibleOrigin = 0;
+	int32 ShotsInvalidSeed = 0;
+
+	int32 GetNumRejected() const { return ShotsRateLimited + ShotsImplausibleOrigin + ShotsInvalidSeed; }
+};
+
+/**
+ * Server-side bookkeeping of the shots weapons accept and reject, per client connection.
+ * The checks themselves run in AWeaponActor::ServerFireBatch, before any tracing or spawning.
+ */
+UCLASS()
+class BONEDSHOOTER_API UFireValidationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	/** Counts a shot received from Connection, accepted when Rejection is None. */
+	void RecordShot(UNetConnection* Connection, EShotRejection Rejection);
+
+	/** Counters of Connection, zero for a connection that never fired. */
+	FFireRejectionStats GetStats(UNetConnection* Connection) const;
+
+	/** Writes the counters of every open connection to the log. */
+	void DumpStats();
+
+private:
+	TMap<TWeakObjectPtr<UNetConnection>, FFireRejectionStats> StatsByConnection;
+};
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProjectilePoolSubsystem.generated.h"
+
+class ABullet;
+
+/** Counters describing how well the pool is covering the demand for bullets. */
+USTRUCT(BlueprintType)
+struct BONEDSHOOTER_API FProjectilePoolStats
+{
+	GENERATED_BODY()
+
+	/** Acquisitions served from an already spawned bullet */
+	UPROPERTY(BlueprintReadOnly, Category = "ProjectilePool")
+	int32 PoolHits = 0;
+
+	/** Acquisitions that had to spawn a new bullet */
+	UPROPERTY(BlueprintReadOnly, Category = "ProjectilePool")
+	int32 PoolMisses = 0;
+
+	/** Bullets currently in flight */
+	UPROPERTY(BlueprintReadOnly, Category = "ProjectilePool")
+	int32 NumActive = 0;
+
+	/** Bullets parked in the pool, ready to be handed out */
+	UPROPERTY(BlueprintReadOnly, Category = "ProjectilePool")
+	int32 NumFree = 0;
+
+	/** Highest number of bullets in flight at the same time */
+	UPROPERTY(BlueprintReadOnly, Category = "ProjectilePool")
+	int32 PeakActive = 0;
+};
+
+/** Pooled bullets of a single projectile class. */
+USTRUCT()
+struct FProjectilePoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<ABullet*> FreeBullets;
+
+	FProjectilePoolStats Stats;
+
+	/** Peak of NumActive since the last trim, used to decide how many free bullets are worth keeping */
+	int32 WindowPeakActive = 0;
+
+	float LastTrimTime = 0.f;
+};
+
+/**
+ * Server-side pool of ABullet actors, keyed by projectile class.
+ * Bullets are pre-spawned, handed out with reset state and parked again on hit or expiry instead of being destroyed.
+ */
+UCLASS(config=Game)
+class BONEDSHOOTER_API UProjectilePoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	/** Makes sure at least Count bullets of the given class are spawned and parked. */
+	void Prewarm(TSubclassOf<ABullet> ProjectileClass, int32 Count);
+
+	/**
+	 * Hands out a bullet of the given class, placed at SpawnTransform and ready to be launched.
+	 * Spawns a new batch if the pool for that class is empty.
+	 */
+	ABullet* AcquireBullet(TSubclassOf<ABullet> ProjectileClass, const FTransform& SpawnTransform, AActor* BulletOwner, APawn* BulletInstigator);
+
+	/** Parks a bullet previously handed out by AcquireBullet. Releasing a bullet that is already parked does nothing. */
+	void ReleaseBullet(ABullet* Bullet);
+
+	UFUNCTION(BlueprintCallable, Category = "ProjectilePool")
+	FProjectilePoolStats GetPoolStats(TSubclassOf<ABullet> ProjectileClass) const;
+
+	/** Bullets in flight, all classes together */
+	int32 GetNumActive() const;
+
+	/** Writes the counters of every bucket to the log. */
+	void DumpStats() const;
+
+protected:
+	/**
+	 * Parked bullets per class that trimming always keeps, however low the recent demand.
+	 * Prewarming is up to the weapons, see AWeaponActor::ProjectilePoolPrewarmCount.
+	 */
+	UPROPERTY(Config)
+	int32 MinFreePerClass = 32;
+
+	/** Bullets spawned at once when the pool runs dry */
+	UPROPERTY(Config)
+	int32 GrowBatchSize = 8;
+
+	/** Upper bound of parked bullets per class, extra returns are destroyed */
+	UPROPERTY(Config)
+	int32 MaxFreePerClass = 256;
+
+	/** Seconds between two shrink passes of a bucket */
+	UPROPERTY(Config)
+	float TrimInterval = 10.f;
+
+	/** Maximum number of bullets destroyed by a single shrink pass, to spread the cost */
+	UPROPERTY(Config)
+	int32 MaxTrimPerPass = 16;
+
+private:
+	ABullet* SpawnPooledBullet(UClass* ProjectileClass);
+	void TrimBucket(FProjectilePoolBucket& Bucket);
+
+	UPROPERTY()
+	TMap<UClass*, FProjectilePoolBucket> Buckets;
+};
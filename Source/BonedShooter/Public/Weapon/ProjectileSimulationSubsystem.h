@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ProjectileSimulationSubsystem.generated.h"
+
+/**
+ * Server-side, actor-less projectile backend.
+ * In-flight bullets live in one structure-of-arrays buffer, are advanced in a single pass per frame and swept
+ * against the world in parallel batches. Only hits come back to the game thread.
+ */
+UCLASS(config=Game)
+class BONEDSHOOTER_API UProjectileSimulationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	// End of FTickableGameObject interface
+
+	/**
+	 * Adds a bullet to the simulation. Only meaningful on the server.
+	 * Gravity and drag follow the same trajectory as UBallisticMovementComponent.
+	 * ShotSequence is handed back with the hit, for the shot telemetry.
+	 */
+	void SpawnProjectile(const FVector& Origin, const FVector& Velocity, float GravityZ, float Drag, float LifeSpan, AActor* ProjectileOwner, APawn* ProjectileInstigator, uint32 ShotSequence);
+
+	UFUNCTION(BlueprintCallable, Category = "ProjectileSimulation")
+	int32 GetNumProjectiles() const { return Positions.Num(); }
+
+protected:
+	/** Radius of the swept sphere, matches the ABullet collision sphere */
+	UPROPERTY(Config)
+	float SweepRadius = 3.f;
+
+	/** Below this many bullets the sweeps run on the game thread, task overhead isn't worth it */
+	UPROPERTY(Config)
+	int32 MinProjectilesForParallelSweep = 32;
+
+private:
+	void RemoveProjectileAtSwap(int32 Index);
+
+	// --- Structure of arrays, one entry per bullet in flight -- //
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<float> GravityZs;
+	TArray<float> Drags;
+	TArray<float> RemainingLife;
+	TArray<TWeakObjectPtr<AActor>> Owners;
+	TArray<TWeakObjectPtr<APawn>> Instigators;
+	TArray<uint32> ShotSequences;
+
+	// --- Per-frame scratch buffers, kept around to avoid reallocating every tick -- //
+	TArray<const AActor*> ScratchIgnoredOwners;
+	TArray<const AActor*> ScratchIgnoredInstigators;
+	TArray<FVector> ScratchNextPositions;
+	TArray<FVector> ScratchNextVelocities;
+	TArray<FHitResult> ScratchHits;
+	TArray<uint8> ScratchHitFlags;
+};
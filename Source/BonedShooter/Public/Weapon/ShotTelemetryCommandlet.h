@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ShotTelemetryCommandlet.generated.h"
+
+/**
+ * Offline analyzer of the logs written by UShotTelemetrySubsystem. Memory-maps every log, joins the shooter's and the
+ * server's records of each shot, then reports how often and how far the two sides disagree and how late shots and
+ * hits land on the server.
+ *
+ *   UE4Editor-Cmd BonedShooter.uproject -run=ShotTelemetry [Log.shots ...] [-Dir=Path] [-DivergenceDegrees=1.0]
+ *
+ * Without log files on the command line, reads every .shots file of -Dir, Saved/ShotTelemetry by default.
+ * Client and server logs of one or more sessions go in the same run, shots are matched by session id, weapon seed and sequence.
+ */
+UCLASS()
+class BONEDSHOOTER_API UShotTelemetryCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UShotTelemetryCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
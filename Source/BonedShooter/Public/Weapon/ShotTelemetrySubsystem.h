@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShotTelemetrySubsystem.generated.h"
+
+class IFileHandle;
+
+/** What a telemetry record describes. */
+enum class EShotTelemetryKind : uint8
+{
+	/** The shooter's side of a shot: aim trace result and aim direction, recorded as the shot is sent */
+	Fire,
+	/** The server's side of a shot: lag compensated aim and spawn direction after spread */
+	Process,
+	/** A bullet of the shot hit something on the server */
+	Hit,
+	/** The ring overflowed before a flush, Sequence holds the number of records lost */
+	Dropped
+};
+
+namespace ShotTelemetryFlags
+{
+	/** Fire: the aim trace hit something. Hit: always set */
+	static constexpr uint8 Blocked = 1 << 0;
+	/** Fire: the aim trace hit a pawn. Hit: the bullet hit a pawn */
+	static constexpr uint8 Pawn = 1 << 1;
+}
+
+/**
+ * One record of the shot telemetry log, fixed size so a log is a plain array of them after the header.
+ * A shot is identified by the session id of its log, the spread seed of its weapon, unique per weapon and known to
+ * both sides, and its sequence.
+ */
+struct FShotTelemetryRecord
+{
+	EShotTelemetryKind Kind = EShotTelemetryKind::Fire;
+	uint8 Flags = 0;
+	uint8 NumPellets = 0;
+	uint8 Reserved = 0;
+
+	/** Player id of the shooter, -1 when it has no player state */
+	int32 ShooterId = -1;
+	int32 WeaponSeed = 0;
+	uint32 Sequence = 0;
+
+	/** Server time the shooter believed it was when the shot left */
+	float ClientFireTime = 0.f;
+	/** World time of the machine that wrote the record */
+	float RecordTime = 0.f;
+	/** Cone half angle of the shot in degrees: the shooter's on Fire, the one the server sampled from on Process */
+	float Spread = 0.f;
+
+	/** Fire: aim direction from the muzzle. Process: aim axis after lag compensation. Hit: bullet direction */
+	FVector Direction = FVector::ZeroVector;
+	/** Process: spawn direction of the first pellet after spread */
+	FVector SpreadDirection = FVector::ZeroVector;
+	/** Fire: where the aim trace stopped. Process: muzzle. Hit: impact point */
+	FVector Location = FVector::ZeroVector;
+};
+static_assert(sizeof(FShotTelemetryRecord) == 64, "Shot telemetry records are written as is, keep their layout stable");
+
+/** Start of a shot telemetry log. */
+struct FShotTelemetryFileHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x54534253; // "SBST"
+	static constexpr uint16 CurrentVersion = 2;
+
+	uint32 Magic = ExpectedMagic;
+	uint16 Version = CurrentVersion;
+	uint16 RecordSize = sizeof(FShotTelemetryRecord);
+	/** ENetMode of the world that wrote the log */
+	uint8 NetMode = 0;
+	uint8 Reserved[3] = {};
+	/** ABonedShooterGameStateBase::GetSessionId, the same in the logs of the server and its clients, 0 without it */
+	uint32 SessionId = 0;
+	/** UTC ticks of the start of the log */
+	int64 StartTicks = 0;
+};
+static_assert(sizeof(FShotTelemetryFileHeader) == 24, "Shot telemetry headers are written as is, keep their layout stable");
+
+/**
+ * Hit registration telemetry. The shooter, the server, or both on a listen server, record every shot into a fixed
+ * ring of records that is appended to a binary log under Saved/ShotTelemetry once a second, or at the end of the frame
+ * it gets half full. Recording copies one record into the ring, it never allocates nor writes.
+ * Logs are read by the ShotTelemetry commandlet.
+ */
+UCLASS(config=Game)
+class BONEDSHOOTER_API UShotTelemetrySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Appends Record to the ring, counted as dropped if the ring is full. */
+	void Record(const FShotTelemetryRecord& Record);
+
+	/** Writes the records of the ring to the log. */
+	void Flush();
+
+protected:
+	/** Turned off by -NoShotTelemetry */
+	UPROPERTY(Config)
+	bool bRecordShots = true;
+
+	/** Records held in memory between two flushes */
+	UPROPERTY(Config)
+	int32 RingCapacity = 16384;
+
+	/** Seconds between two flushes */
+	UPROPERTY(Config)
+	float FlushInterval = 1.f;
+
+private:
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	/**
+	 * Opened on the first flush with records, so worlds nobody fires in don't leave empty logs behind, and not before
+	 * the session id has replicated. False while waiting for it, records stay in the ring until then.
+	 */
+	bool OpenLog();
+
+	TArray<FShotTelemetryRecord> Ring;
+	/** Records ever written to the ring and ever flushed, their difference is what the ring holds */
+	uint64 Head = 0;
+	uint64 Tail = 0;
+	uint32 NumDropped = 0;
+
+	TUniquePtr<IFileHandle> LogFile;
+	bool bLogFailed = false;
+	float LastFlushTime = 0.f;
+	/** The ring got half full, flushed after the actors tick */
+	bool bFlushRequested = false;
+
+	FDelegateHandle PostActorTickHandle;
+};
@@ -6,12 +6,40 @@
 
 #include "Camera/CameraComponent.h"
 #include "GameFramework/Actor.h"
+#include "WorldCollision.h"
+#include "Weapon/FireValidationSubsystem.h"
+#include "Weapon/WeaponFireScheduler.h"
+#include "Weapon/WeaponShot.h"
+#include "Weapon/WeaponSpreadModel.h"
 #include "WeaponActor.generated.h"
 
+/** How the server simulates the bullets fired by a weapon. */
+UENUM(BlueprintType)
+enum class EProjectileBackend : uint8
+{
+	/** Every bullet is a replicated ABullet actor, taken from the projectile pool */
+	Actor,
+	/** Bullets are simulated in bulk by UProjectileSimulationSubsystem, clients only spawn cosmetic actors */
+	Batched
+};
+
+/** How the weapon finds what the crosshair points at. */
+UENUM(BlueprintType)
+enum class EAimTraceMode : uint8
+{
+	/** Traces on the game thread as the shot is fired */
+	Synchronous,
+	/** Traces of a frame are batched and run off the game thread, shots leave one frame later */
+	Asynchronous
+};
+
 UCLASS()
 class BONEDSHOOTER_API AWeaponActor : public AActor
 {
 	GENERATED_BODY()
+
+	/** Times the aim trace setup of a bare weapon */
+	friend class UWeaponBenchmarkCommandlet;
 	
 public:	
 	// Sets default values for this actor's properties
@@ -23,6 +51,13 @@ public:
 	// Projectile class to spawn.
 	UPROPERTY(EditDefaultsOnly, Category = Projectile)
 	TSubclassOf<class ABullet> ProjectileClass;
+
+	// Bullets spawned up front in the projectile pool when the weapon enters play on the server.
+	UPROPERTY(EditDefaultsOnly, Category = Projectile)
+	int32 ProjectilePoolPrewarmCount;
+
+	UPROPERTY(EditDefaultsOnly, Category = Projectile)
+	EProjectileBackend ProjectileBackend;
 	
 	UPROPERTY(Replicated, EditDefaultsOnly, BlueprintReadOnly, Category = "BonedShooterCharacter|Weapon")
 	FName HandleSocketName;
@@ -30,6 +65,33 @@ public:
 	UPROPERTY(Replicated, EditDefaultsOnly, BlueprintReadOnly, Category = "BonedShooterCharacter|Weapon")
 	FName MuzzleSocketName;
 
+	/** Spread as the crosshair shows it, in the units of the spread specs */
+	UFUNCTION(BlueprintPure, Category = "BonedShooterCharacter|Weapon")
+	float GetCurrentSpread() const;
+
+	float GetSpreadAt(float Time) const;
+
+	/** Half angle, in degrees, of the cone the next bullet is drawn from */
+	float GetSpreadConeHalfAngle() const;
+	float GetSpreadConeHalfAngleAt(float Time) const;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/**
+	 * Server: wakes the weapon's channel up for firing, or lets it go dormant again after DormancyDelay.
+	 * RPCs need the channel, the replicated state alone only changes on equip.
+	 */
+	void SetReplicationAwake(bool bAwake);
+
+	float GetDefaultDamage() const { return DefaultDamage; }
+	TSubclassOf<UDamageType> GetDamageTypeClass() const { return DamageTypeClass; }
+
+	/** Unique to this weapon and identical on every machine, identifies its shots in the shot telemetry */
+	int32 GetSpreadSeed() const { return SpreadSeed; }
+
+	/** Player id of the owner, -1 when it has no player state */
+	int32 GetShooterId() const;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -47,17 +109,187 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "BonedShooterCharacter|Weapon")
 	TSubclassOf<UDamageType> DamageTypeClass;
 
+	/** Curve table with the BaseSpread, MaxIdleSpread, MaxWalkSpread, SpreadSpeed and SpreadCooldown rows */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Spread")
+	class UCurveTable* SpreadSpecsTable;
+
+	/** Values used for the rows SpreadSpecsTable doesn't have */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Spread")
+	FWeaponSpreadSpecs DefaultSpreadSpecs;
+
+	/**
+	 * Degrees of cone half angle per spread specs unit. The specs are in crosshair units, while the Blueprint
+	 * drew bullets from DT_WeaponSpread: a 2 degree base, doubled when moving and multiplied by 2.4 when firing.
+	 * The default maps MaxIdleSpread (150) to the 4.8 degrees of firing while standing and MaxWalkSpread (300)
+	 * to the 9.6 degrees of firing on the move
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Spread")
+	float ConeDegreesPerSpreadUnit;
+
 	UFUNCTION(BlueprintCallable, Category = "BonedShooterCharacter|Weapon")
 	virtual void Fire();
 
-	UFUNCTION(Server, Reliable, WithValidation)
-	void ServerFire(AActor* ProjectileOwner, APawn* ProjectileInstigator, FVector SpawnLocation, FVector ProjectileDestination);
+	/**
+	 * Fires a shot that was due at ShotTime, earlier in the current frame.
+	 * @param FrameAlpha	Where ShotTime falls between the previous frame (0) and the current one (1)
+	 */
+	void FireShot(float ShotTime, float FrameAlpha);
+
+	/**
+	 * Projectiles per shot, above 1 for shotgun-style weapons. A volley costs the RPC, aim trace and lag compensation
+	 * of a single shot, the batched projectile backend also sweeps its pellets together.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon", meta = (ClampMin = "1", ClampMax = "32"))
+	int32 PelletCount;
+
+	/** Smallest cone half angle the pellets of a volley spread over, in degrees, however tight the weapon spread */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Spread")
+	float MinPelletSpread;
+
+	/** Upper bound of shots fired in a single frame, the rest are fired in the next frames */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon")
+	int32 MaxShotsPerFrame;
+
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Aim")
+	EAimTraceMode AimTraceMode;
+
+	/** Trace the aim against complex collision. Simple collision is cheaper on long rays through detailed geometry, at the cost of precision. */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Aim")
+	bool bAimTraceComplex;
+
+	/** Sends the shots fired since the last flush, plus any not acknowledged yet, to the server. */
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerFireBatch(const FWeaponShotBatch& Batch);
+
+	/** Tells the owning client every shot up to LastProcessedSequence has been processed. */
+	UFUNCTION(Client, Unreliable)
+	void ClientAckShots(uint32 LastProcessedSequence);
+
+	/** Simulates a single shot on the server. Sequence numbers the shot for the shot telemetry. */
+	void ProcessShot(const FWeaponShot& Shot, uint32 Sequence);
+
+	/** Seconds shots are held before being sent, 0 sends the shots of a frame together at the next frame */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Network")
+	float ShotBatchWindow;
+
+	/** Seconds the weapon stays awake after its owner stops aiming */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Network")
+	float DormancyDelay;
+
+	/** Seconds between two retransmissions of shots the server hasn't acknowledged */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Network")
+	float ShotResendInterval;
+
+	/**
+	 * Shots the server accepts back to back from a client, on top of the fire rate. The rate is checked against the
+	 * times the shots were fired, so batches bunched up by the network or resent after a loss don't use it up.
+	 * Absorbs the catch-up shots after a hitch and clock jitter, anything beyond is dropped without being simulated.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Validation", meta = (ClampMin = "1"))
+	int32 ShotBurstAllowance;
+
+	/** Fire rate the server accepts, as a multiple of the one TimeBetweenShots gives, for clock drift between the machines */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Validation", meta = (ClampMin = "1"))
+	float FireRateTolerance;
+
+	/**
+	 * Distance the server accepts between a shot's origin and its own muzzle location, on top of how far the owner
+	 * can have moved since the shot was fired.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Validation")
+	float MaxMuzzleOffset;
+
+	/**
+	 * Server: cheap checks of a client shot, no trace and no spawn, before it gets simulated.
+	 * NumSkipped shots of the client's sequence came between the previous shot and this one.
+	 */
+	EShotRejection ValidateShot(const FWeaponShot& Shot, uint32 NumSkipped, float Now);
+
+	/** Spread the server accepts for Shot fired at ShotTime, the client's unless it is too tight */
+	float GetValidatedSpread(const FWeaponShot& Shot, float ShotTime) const;
+
+	/** Server time Shot was fired at, from its ClientFireTime, never in the future nor older than a second */
+	float GetShotTime(const FWeaponShot& Shot) const;
+
+	/** Final directions of the pellets of a shot around AimAxis, identical on every machine for the same spread. */
+	void ComputePelletDirections(const FVector& AimAxis, float Spread, int32 Seed, TArrayView<FVector> OutDirections) const;
+
+	int32 GetNumPellets() const { return FMath::Clamp(PelletCount, 1, WEAPON_MAX_PELLETS); }
+
+	/** The server uses the spread the client sent when it is at most this far below its own, in degrees */
+	UPROPERTY(EditDefaultsOnly, Category = "BonedShooterCharacter|Weapon|Spread")
+	float SpreadTolerance;
+
+	/**
+	 * Spawns the visuals of a volley simulated by the batched backend on every client the weapon is relevant to.
+	 * Clients sample the pellet directions from the seed, one message whatever the pellet count.
+	 */
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastSpawnCosmeticVolley(FVector_NetQuantize SpawnLocation, FVector_NetQuantizeNormal AimAxis, uint16 QuantizedSpread, int32 Seed);
 	
 private:
+	FWeaponSpreadModel SpreadModel;
+
 	float LastFireTime = 0.f;
-	FTimerHandle TimerHandle_AutoFire;
+	FWeaponFireScheduler FireScheduler;
+
+	/**
+	 * Aims the shot at ProjectileTarget and hands it to the network.
+	 * @param AimHitActor	What the aim trace hit, if it hit anything, recorded by the shot telemetry
+	 */
+	void CompleteShot(FWeaponShot& Shot, const FVector& MuzzleLocation, const FVector& ProjectileTarget, bool bAimHit, const AActor* AimHitActor);
+
+	void OnAimTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+	FTraceDelegate AimTraceDelegate;
+
+	/** Shots waiting for their async aim trace, by trace user data */
+	struct FPendingAimShot
+	{
+		FWeaponShot Shot;
+		FVector MuzzleLocation;
+		FVector TraceEnd;
+	};
+	TMap<uint32, FPendingAimShot> PendingAimShots;
+	uint32 NextAimTraceKey = 0;
+
+	/** Built once per owner instead of once per shot */
+	const FCollisionQueryParams& GetAimQueryParams();
+	FCollisionQueryParams AimQueryParams;
+	TWeakObjectPtr<AActor> AimQueryParamsOwner;
+
+	/** Viewpoint and muzzle at the end of the previous frame, for shots due between two frames */
+	void CacheShotViewpoint();
+	FVector PreviousEyeLocation = FVector::ZeroVector;
+	FRotator PreviousEyeRotation = FRotator::ZeroRotator;
+	FVector PreviousMuzzleLocation = FVector::ZeroVector;
 
+	/** Picked by the server, combined with the burst and shot index to seed the spread of every shot */
 	UPROPERTY(Replicated)
-	FVector ProjectileDirection;
+	int32 SpreadSeed;
+
+	uint16 BurstSeed = 0;
+	uint16 ShotIndexInBurst = 0;
+
+	/** Sends the shot, or simulates it right away on the server, and returns its sequence */
+	uint32 QueueShot(const FWeaponShot& Shot);
+	void FlushShots();
+
+	/** Client: shots sent but not acknowledged yet */
+	FWeaponShotSendQueue UnackedShots;
+	FTimerHandle TimerHandle_FlushShots;
+	bool bShotFlushPending = false;
+
+	FTimerHandle TimerHandle_Dormancy;
+
+	/** Server: sequence of the last shot simulated, also numbers the server's own shots */
+	FWeaponShotReceiveState ReceivedShots;
+
+	/** Server: burst and index of the last shot of the owning client, the spread seed of the next one follows from them */
+	FWeaponShotSeedTracker ReceivedShotSeeds;
+
+	/** Server: token bucket of the owning client's shots, refilled at the fire rate up to ShotBurstAllowance */
+	float ShotTokens = 0.f;
+	/** Server: fire time of the latest shot the bucket was refilled for */
+	float ShotTokensTime = 0.f;
 
 };
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "WeaponBenchmarkCommandlet.generated.h"
+
+class ABullet;
+
+/** One measurement of a benchmark run, lower is better. */
+struct FWeaponBenchmarkMetric
+{
+	/** Stable across runs and versions, baselines are matched by name */
+	FString Name;
+	double Value = 0.0;
+	/** Peaks are reported but too noisy to fail a run on */
+	bool bGated = true;
+};
+
+/**
+ * Benchmarks of the weapon pipeline, from the cone sampler to a 1000-bullet firefight, in a transient empty world.
+ * Writes the results as JSON and compares them against a baseline, the run fails when a gated metric is slower than
+ * its baseline by more than the tolerance, and when a metric is missing from the baseline. Without a baseline the
+ * comparison is skipped with a warning.
+ *
+ *   UE4Editor-Cmd BonedShooter.uproject -run=WeaponBenchmark -nullrhi -unattended
+ *     [-Output=Path] [-Baseline=Path] [-Tolerance=0.15] [-UpdateBaseline]
+ *
+ * -UpdateBaseline overwrites the baseline with the results of the run, to be committed along with the change that
+ * moved the numbers, from the machine the baseline was first recorded on (its Cpu field).
+ */
+UCLASS(config=Game)
+class BONEDSHOOTER_API UWeaponBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UWeaponBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	/** Bullet used by the spawn benchmark and the actor backend of the firefight */
+	UPROPERTY(Config)
+	FSoftClassPath BulletClass;
+
+	/** Results written when -Output isn't given, relative to the project's Saved directory */
+	UPROPERTY(Config)
+	FString DefaultOutputFile = TEXT("Benchmarks/WeaponBenchmark.json");
+
+	/** Baseline read when -Baseline isn't given, relative to the project directory */
+	UPROPERTY(Config)
+	FString DefaultBaselineFile = TEXT("Build/Benchmarks/WeaponBenchmark.json");
+
+	/** Fraction a gated metric may exceed its baseline by before the run fails */
+	UPROPERTY(Config)
+	float Tolerance = 0.15f;
+
+	/** Calls timed per repetition of a micro-benchmark */
+	UPROPERTY(Config)
+	int32 MicroIterations = 10000;
+
+	/** Repetitions of a micro-benchmark, the median is kept */
+	UPROPERTY(Config)
+	int32 MicroRepetitions = 7;
+
+	/** Bullets fired over the course of the firefight */
+	UPROPERTY(Config)
+	int32 FirefightBullets = 1000;
+
+	/** Frames the firefight's bullets are fired over */
+	UPROPERTY(Config)
+	int32 FirefightSpawnFrames = 10;
+
+	/** Frames recorded from the first shot, long enough for every bullet to land */
+	UPROPERTY(Config)
+	int32 FirefightFrames = 90;
+
+private:
+	/** Times Body(MicroIterations) once per repetition and records the median, in nanoseconds per iteration. */
+	void RunMicro(const TCHAR* Name, TFunctionRef<void(int32)> Body);
+
+	void RunConeSampling();
+	void RunSpreadEvaluation();
+	void RunAimTrace(UWorld* World);
+	void RunBulletLaunch(UWorld* World, TSubclassOf<ABullet> ProjectileClass);
+	void RunFirefight(UWorld* World, TSubclassOf<ABullet> ProjectileClass, bool bBatched);
+
+	/** Floor and two facing walls of targets, the firefight's bullets fly from one wall to the other */
+	void BuildArena(UWorld* World);
+
+	bool WriteResults(const FString& Path) const;
+
+	/** Compares the results against the baseline at Path, returns false on a regression */
+	bool CompareAgainstBaseline(const FString& Path, float InTolerance) const;
+
+	TArray<FWeaponBenchmarkMetric> Metrics;
+};
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Automatic fire driven by an accumulator rather than a timer.
+ * Each frame reports every shot that fell inside it with its exact time, so the fire rate does not depend on the
+ * frame rate, even when the fire interval is shorter than a frame or a frame hitches.
+ */
+struct BONEDSHOOTER_API FWeaponFireScheduler
+{
+	/** Starts firing every Interval seconds, the first shot at Now or EarliestFirstShotTime, whichever is later. */
+	void Start(float Now, float Interval, float EarliestFirstShotTime);
+
+	void Stop();
+
+	bool IsFiring() const { return bIsFiring; }
+
+	/**
+	 * Appends the times of the shots due up to Now, oldest first, at most MaxShots of them.
+	 * Shots over the cap are not lost, they come out in the following frames.
+	 */
+	void Advance(float Now, int32 MaxShots, TArray<float, TInlineAllocator<16>>& OutShotTimes);
+
+private:
+	float GetShotTime(int32 ShotIndex) const { return FirstShotTime + ShotIndex * ShotInterval; }
+
+	float FirstShotTime = 0.f;
+	float ShotInterval = 0.f;
+	/** Shots fired since Start */
+	int32 NumShotsFired = 0;
+	bool bIsFiring = false;
+};
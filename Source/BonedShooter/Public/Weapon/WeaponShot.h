@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "WeaponShot.generated.h"
+
+/**
+ * Everything the server needs to reproduce a shot of the owning client.
+ * The spread is not rolled by either side: it is drawn from a cone keyed by the seed fields, see FWeaponConeSampler.
+ * A shot of a multi-pellet weapon is the whole volley, the pellets are drawn from the same seed.
+ */
+USTRUCT()
+struct BONEDSHOOTER_API FWeaponShot
+{
+	GENERATED_BODY()
+
+	/** Muzzle location, to 0.1 units */
+	UPROPERTY()
+	FVector_NetQuantize10 Origin;
+
+	/** Direction from the muzzle to what the crosshair points at, before spread */
+	UPROPERTY()
+	FVector_NetQuantizeNormal AimDirection;
+
+	/** Changes every time the trigger is pulled */
+	UPROPERTY()
+	uint16 BurstSeed = 0;
+
+	/** Index of the shot within the burst */
+	UPROPERTY()
+	uint16 ShotIndex = 0;
+
+	/** Cone half angle the client used, in hundredths of a degree */
+	UPROPERTY()
+	uint16 QuantizedSpread = 0;
+
+	/** Server world time as seen by the client when it fired, used for lag compensation */
+	UPROPERTY()
+	float ClientFireTime = 0.f;
+
+	float GetSpread() const { return QuantizedSpread / 100.f; }
+	void SetSpread(float HalfAngleDegrees) { QuantizedSpread = (uint16)FMath::Clamp(FMath::RoundToInt(HalfAngleDegrees * 100.f), 0, (int32)MAX_uint16); }
+};
+
+/**
+ * Shots sent together by the owning client over an unreliable RPC.
+ * Shots are numbered, the batch always starts at the oldest shot the server has not acknowledged yet,
+ * so a lost batch is covered by the next one and the server can drop what it already processed.
+ */
+USTRUCT()
+struct BONEDSHOOTER_API FWeaponShotBatch
+{
+	GENERATED_BODY()
+
+	/** Sequence number of Shots[0], the following shots are numbered consecutively */
+	UPROPERTY()
+	uint32 FirstSequence = 0;
+
+	UPROPERTY()
+	TArray<FWeaponShot> Shots;
+};
+
+/**
+ * Client side of the shot stream: the shots sent but not acknowledged yet. Every batch starts at the oldest of them,
+ * so shots are resent until the server acknowledges them, whatever batches get lost or reordered on the way.
+ */
+struct BONEDSHOOTER_API FWeaponShotSendQueue
+{
+	/** Appends Shot and returns its sequence. With MaxUnacked shots already waiting, the oldest one is given up. */
+	uint32 Add(const FWeaponShot& Shot, int32 MaxUnacked);
+
+	/** Fills OutBatch with the oldest shots, at most MaxShots of them. False when every shot was acknowledged. */
+	bool MakeBatch(int32 MaxShots, FWeaponShotBatch& OutBatch) const;
+
+	/** Forgets every shot up to LastProcessedSequence. Late and repeated acks are ignored. */
+	void Acknowledge(uint32 LastProcessedSequence);
+
+	int32 Num() const { return Shots.Num(); }
+	bool IsEmpty() const { return Shots.Num() == 0; }
+
+private:
+	/** Shots[0] has sequence FirstSequence */
+	TArray<FWeaponShot> Shots;
+	uint32 FirstSequence = 1;
+};
+
+/** Server side of the shot stream: picks the shots of a batch that were not processed yet. */
+struct BONEDSHOOTER_API FWeaponShotReceiveState
+{
+	/** True the first time a shot with Sequence arrives, it then counts as processed, for the acknowledgement. */
+	bool Accept(uint32 Sequence);
+
+	/** Sequence of a shot the server fires itself, it never goes through a batch */
+	uint32 AcceptLocal() { return ++LastProcessedSequence; }
+
+	/** Every shot up to this one was processed, what ClientAckShots reports */
+	uint32 GetLastProcessedSequence() const { return LastProcessedSequence; }
+
+private:
+	uint32 LastProcessedSequence = 0;
+};
+
+/**
+ * Server side check of the seed fields of a client's shots. They pick the spread of a shot, a client free to choose them
+ * could search for the seed that puts the cone on target. Every trigger pull is the next burst, every shot of a burst
+ * the next index, so the fields of a shot follow from those of the previous one. Shots the client gave up in between
+ * only leave room for as many bursts or indices as there were of them.
+ */
+struct BONEDSHOOTER_API FWeaponShotSeedTracker
+{
+	/** True if BurstSeed and ShotIndex may follow the previous shot, NumSkipped shots later. Then remembers them. */
+	bool Accept(uint16 BurstSeed, uint16 ShotIndex, uint32 NumSkipped);
+
+private:
+	/** The client's first trigger pull is burst 1, burst 0 never has a shot */
+	uint16 LastBurstSeed = 0;
+	uint16 LastShotIndex = MAX_uint16;
+};
+
+/** Upper bound of pellets in a volley, lets the directions of a volley live on the stack */
+#define WEAPON_MAX_PELLETS 32
+
+/** Deterministic cone sampling shared by clients and server. Same inputs, same directions, on every machine. */
+struct BONEDSHOOTER_API FWeaponConeSampler
+{
+	/** Seed of a shot, from the replicated seed of the weapon and the position of the shot in its burst. */
+	static int32 MakeSeed(int32 WeaponSeed, uint16 BurstSeed, uint16 ShotIndex);
+
+	/**
+	 * Fills OutDirections with directions uniformly spread inside the cone of half angle HalfAngleDegrees around Axis,
+	 * fully determined by Seed. The pellets of a volley are sampled together, four at a time in vector registers.
+	 */
+	static void SampleDirections(const FVector& Axis, float HalfAngleDegrees, int32 Seed, TArrayView<FVector> OutDirections);
+};
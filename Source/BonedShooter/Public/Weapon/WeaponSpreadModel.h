@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WeaponSpreadModel.generated.h"
+
+class UCurveTable;
+
+/** Spread parameters of a weapon, compiled once from a CT_WeaponSpreadSpecs-like curve table. */
+USTRUCT(BlueprintType)
+struct BONEDSHOOTER_API FWeaponSpreadSpecs
+{
+	GENERATED_BODY()
+
+	/** Spread of a resting weapon */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Spread")
+	float BaseSpread = 3.f;
+
+	/** Spread cap while standing still */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Spread")
+	float MaxIdleSpread = 150.f;
+
+	/** Spread cap while moving at WalkSpeedReference or faster */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Spread")
+	float MaxWalkSpread = 300.f;
+
+	/** Spread added by every shot */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Spread")
+	float SpreadSpeed = 100.f;
+
+	/** Spread recovered per second */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Spread")
+	float SpreadCooldown = 50.f;
+
+	/** Speed at which the cap reaches MaxWalkSpread, not part of the curve table */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Spread")
+	float WalkSpeedReference = 600.f;
+
+	/** Scale applied to the spread while aiming down sights, not part of the curve table */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Spread")
+	float AimingSpreadScale = 1.f;
+
+	/** Reads the rows of SpecsTable, keeping the current value for any missing row. */
+	static FWeaponSpreadSpecs FromCurveTable(const UCurveTable* SpecsTable, const FWeaponSpreadSpecs& Defaults);
+};
+
+/**
+ * Deterministic spread of a weapon: a pure function of the specs, the shot history, the movement speed and the time.
+ * Client and server each run it on their own, so nothing of it has to be replicated.
+ */
+struct BONEDSHOOTER_API FWeaponSpreadModel
+{
+	void SetSpecs(const FWeaponSpreadSpecs& InSpecs) { Specs = InSpecs; }
+	const FWeaponSpreadSpecs& GetSpecs() const { return Specs; }
+
+	/** Spread at time Now for a shooter moving at Speed. */
+	float Evaluate(float Now, float Speed, bool bIsAiming) const;
+
+	/** Accounts for a shot fired at time Now. */
+	void RecordShot(float Now);
+
+private:
+	/** Spread accumulated by shots above BaseSpread, as of LastShotTime */
+	float HeatAtLastShot = 0.f;
+	float LastShotTime = 0.f;
+
+	float GetHeat(float Now) const;
+
+	FWeaponSpreadSpecs Specs;
+};
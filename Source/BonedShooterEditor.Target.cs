@@ -10,5 +10,6 @@ public class BonedShooterEditorTarget : TargetRules
 		Type = TargetType.Editor;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
 		ExtraModuleNames.Add("BonedShooter");
+		ExtraModuleNames.Add("BonedShooterEditor");
 	}
 }
@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AnimGraphNode_BoneScaling.h"
+
+#define LOCTEXT_NAMESPACE "AnimGraphNode_BoneScaling"
+
+FText UAnimGraphNode_BoneScaling::GetControllerDescription() const
+{
+	return LOCTEXT("BoneScaling", "Bone Scaling");
+}
+
+FText UAnimGraphNode_BoneScaling::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return GetControllerDescription();
+}
+
+FText UAnimGraphNode_BoneScaling::GetTooltipText() const
+{
+	return LOCTEXT("BoneScalingTooltip", "Scales the bones replicated by the owning BonedShooter character. Requires a BonedShooterAnimInstance.");
+}
+
+#undef LOCTEXT_NAMESPACE